@@ -1,24 +1,357 @@
 use a5;
-use std::ffi::{CStr, CString};
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::{Cell, RefCell, UnsafeCell};
+use std::ffi::c_void;
+use std::os::raw::c_char;
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+
+/// Status codes returned by every fallible entry point. Failing calls only record their message
+/// for the calling thread; it is formatted for the caller on demand by `a5_last_error_message`,
+/// so rows that fail inside a TRY_ function never cross the FFI boundary as heap strings.
+pub const A5_OK: i32 = 0;
+/// The a5 crate rejected the input; the message is available from `a5_last_error_message`
+pub const A5_ERROR: i32 = 1;
+/// The caller's sink could not provide an output buffer
+pub const A5_ERROR_ALLOCATION: i32 = 2;
+
+thread_local! {
+    static LAST_ERROR: RefCell<String> = RefCell::new(String::new());
+}
+
+fn set_last_error(message: String) -> i32 {
+    // The message is copied into the thread's own buffer, which is never routed to the caller's
+    // allocator because it outlives the call
+    let _system = AllocatorScope::enter(std::ptr::null());
+    LAST_ERROR.with(|last| {
+        let mut last = last.borrow_mut();
+        last.clear();
+        last.push_str(&message);
+    });
+    A5_ERROR
+}
+
+fn panic_message(payload: Box<dyn std::any::Any + Send>) -> String {
+    let detail = if let Some(message) = payload.downcast_ref::<&str>() {
+        message.to_string()
+    } else if let Some(message) = payload.downcast_ref::<String>() {
+        message.clone()
+    } else {
+        "unknown panic".to_string()
+    };
+    format!("internal error in the a5 library: {}", detail)
+}
+
+/// Runs the body of an entry point. A panic in the a5 crate must not unwind across the FFI
+/// boundary: it is caught, recorded like any other error and reported through `on_panic` with
+/// `A5_ERROR`.
+fn guarded<T>(on_panic: impl FnOnce(i32) -> T, body: impl FnOnce() -> T) -> T {
+    match catch_unwind(AssertUnwindSafe(body)) {
+        Ok(value) => value,
+        Err(payload) => on_panic(set_last_error(panic_message(payload))),
+    }
+}
+
+/// Runs one row of a batch, turning a panic into a failed row. The message is recorded so the
+/// caller can report it like a conversion error.
+fn guarded_row<T>(row: impl FnOnce() -> Option<T>) -> Option<T> {
+    catch_unwind(AssertUnwindSafe(row)).unwrap_or_else(|payload| {
+        set_last_error(panic_message(payload));
+        None
+    })
+}
+
+/// Allocation callbacks of the caller, typically its memory-tracked allocator. `allocate` returns
+/// null when it cannot serve the request (for example past a memory limit), in which case the
+/// allocation falls back to the system allocator and is counted for `a5_take_allocator_fallbacks`.
+/// `free` receives the size passed to `allocate`.
+#[repr(C)]
+pub struct A5Allocator {
+    pub allocate: extern "C" fn(ctx: *mut c_void, size: usize) -> *mut c_void,
+    pub free: extern "C" fn(ctx: *mut c_void, ptr: *mut c_void, size: usize),
+    pub ctx: *mut c_void,
+}
+
+/// Whether any caller routes allocations at all. While it is false every allocation goes straight
+/// to the system allocator without reading the thread's route.
+static ROUTING_ENABLED: AtomicBool = AtomicBool::new(false);
+
+/// Turns allocation routing on or off for the whole process. Threads only route while they also
+/// have an allocator set with `a5_set_thread_allocator`.
+#[no_mangle]
+pub extern "C" fn a5_set_allocator_routing(enabled: bool) {
+    ROUTING_ENABLED.store(enabled, Ordering::Release);
+}
+
+/// Routes the allocations the calling thread makes in subsequent calls through `allocator`, or
+/// back to the system allocator when it is null, and returns the previous allocator of the thread
+/// so the caller can restore it. The callbacks must stay callable for as long as any block they
+/// handed out may be freed: blocks remember the allocator that served them, so switching
+/// allocators never frees a block through the wrong one.
+#[no_mangle]
+pub extern "C" fn a5_set_thread_allocator(allocator: *const A5Allocator) -> *const A5Allocator {
+    CURRENT_ROUTE.try_with(|current| current.replace(allocator)).unwrap_or(std::ptr::null())
+}
+
+/// Returns the number of allocations the calling thread made while it had an allocator set that
+/// were served by the system allocator instead, because the allocator returned null or the block
+/// could not be registered, and resets the count
+#[no_mangle]
+pub extern "C" fn a5_take_allocator_fallbacks() -> u64 {
+    ROUTE_FALLBACKS.try_with(|fallbacks| fallbacks.replace(0)).unwrap_or(0)
+}
+
+thread_local! {
+    // Allocator set by the caller for this thread, null for the system allocator
+    static CURRENT_ROUTE: Cell<*const A5Allocator> = const { Cell::new(std::ptr::null()) };
+    // Allocations of this thread that fell back from its allocator to the system allocator
+    static ROUTE_FALLBACKS: Cell<u64> = const { Cell::new(0) };
+}
+
+/// Sets the calling thread's allocator until dropped
+struct AllocatorScope {
+    previous: *const A5Allocator,
+}
+
+impl AllocatorScope {
+    fn enter(route: *const A5Allocator) -> Self {
+        AllocatorScope { previous: a5_set_thread_allocator(route) }
+    }
+}
+
+impl Drop for AllocatorScope {
+    fn drop(&mut self) {
+        a5_set_thread_allocator(self.previous);
+    }
+}
+
+/// Largest alignment served by the caller's allocator; blocks with stricter alignment always come
+/// from the system allocator
+const ROUTED_ALIGNMENT: usize = 16;
+
+const REGISTRY_SHARDS: usize = 64;
+const SHARD_SLOTS: usize = 1024;
+/// Past this load a shard takes no more blocks and new ones come from the system allocator
+const SHARD_CAPACITY: usize = SHARD_SLOTS * 3 / 4;
+
+#[derive(Clone, Copy)]
+struct RoutedBlock {
+    address: usize,
+    owner: *const A5Allocator,
+}
+
+/// Open-addressing table of routed blocks, locked by a spin lock: the critical sections are a few
+/// probes, and a lock that allocated on first use would re-enter the global allocator.
+struct RegistryShard {
+    locked: AtomicBool,
+    len: UnsafeCell<usize>,
+    slots: UnsafeCell<*mut RoutedBlock>,
+}
+
+unsafe impl Sync for RegistryShard {}
+
+#[allow(clippy::declare_interior_mutable_const)]
+const EMPTY_SHARD: RegistryShard = RegistryShard {
+    locked: AtomicBool::new(false),
+    len: UnsafeCell::new(0),
+    slots: UnsafeCell::new(std::ptr::null_mut()),
+};
+
+/// The blocks served by a caller's allocator, with the allocator that served them. Blocks from the
+/// system allocator carry no bookkeeping, so they are only told apart from routed ones by their
+/// absence here; `ROUTED_BLOCKS` lets frees skip the lookup while no routed block is live.
+static REGISTRY: [RegistryShard; REGISTRY_SHARDS] = [EMPTY_SHARD; REGISTRY_SHARDS];
+static ROUTED_BLOCKS: AtomicUsize = AtomicUsize::new(0);
+
+fn block_hash(address: usize) -> u64 {
+    ((address >> 4) as u64).wrapping_mul(0x9E37_79B9_7F4A_7C15)
+}
+
+fn home_slot(address: usize) -> usize {
+    (block_hash(address) >> 32) as usize & (SHARD_SLOTS - 1)
+}
+
+impl RegistryShard {
+    fn of(address: usize) -> &'static RegistryShard {
+        &REGISTRY[(block_hash(address) >> 58) as usize]
+    }
+
+    fn with<R>(&self, body: impl FnOnce(&mut usize, &mut *mut RoutedBlock) -> R) -> R {
+        while self.locked.compare_exchange_weak(false, true, Ordering::Acquire, Ordering::Relaxed).is_err() {
+            std::hint::spin_loop();
+        }
+        let result = unsafe { body(&mut *self.len.get(), &mut *self.slots.get()) };
+        self.locked.store(false, Ordering::Release);
+        result
+    }
+
+    unsafe fn find(slots: *mut RoutedBlock, address: usize) -> Option<usize> {
+        let mut i = home_slot(address);
+        loop {
+            match (*slots.add(i)).address {
+                0 => return None,
+                found if found == address => return Some(i),
+                _ => i = (i + 1) & (SHARD_SLOTS - 1),
+            }
+        }
+    }
+
+    /// Records a routed block, or returns false when the shard is full
+    fn insert(address: usize, owner: *const A5Allocator) -> bool {
+        Self::of(address).with(|len, slots| unsafe {
+            if slots.is_null() {
+                *slots = System.alloc_zeroed(Layout::array::<RoutedBlock>(SHARD_SLOTS).unwrap()) as *mut RoutedBlock;
+            }
+            if slots.is_null() || *len >= SHARD_CAPACITY {
+                return false;
+            }
+            let mut i = home_slot(address);
+            while (*slots.add(i)).address != 0 {
+                i = (i + 1) & (SHARD_SLOTS - 1);
+            }
+            *slots.add(i) = RoutedBlock { address, owner };
+            *len += 1;
+            true
+        })
+    }
+
+    fn contains(address: usize) -> bool {
+        Self::of(address).with(|_, slots| unsafe { !slots.is_null() && Self::find(*slots, address).is_some() })
+    }
+
+    /// Forgets a routed block and returns the allocator that served it, or null for a system block
+    fn remove(address: usize) -> *const A5Allocator {
+        Self::of(address).with(|len, slots| unsafe {
+            if slots.is_null() {
+                return std::ptr::null();
+            }
+            let slots = *slots;
+            let mut hole = match Self::find(slots, address) {
+                Some(i) => i,
+                None => return std::ptr::null(),
+            };
+            let owner = (*slots.add(hole)).owner;
+            // Shift the rest of the probe run back so lookups never stop at the freed slot
+            let mut i = hole;
+            loop {
+                i = (i + 1) & (SHARD_SLOTS - 1);
+                let block = *slots.add(i);
+                if block.address == 0 {
+                    break;
+                }
+                let home = home_slot(block.address);
+                if (i.wrapping_sub(home) & (SHARD_SLOTS - 1)) >= (i.wrapping_sub(hole) & (SHARD_SLOTS - 1)) {
+                    *slots.add(hole) = block;
+                    hole = i;
+                }
+            }
+            (*slots.add(hole)).address = 0;
+            *len -= 1;
+            owner
+        })
+    }
+}
+
+/// Serves Rust allocations from the calling thread's allocator while routing is enabled, and from
+/// the system allocator otherwise. With routing disabled it adds one relaxed load to each
+/// allocation and each free and nothing else: blocks carry no header.
+struct A5GlobalAllocator;
+
+impl A5GlobalAllocator {
+    fn thread_route() -> *const A5Allocator {
+        if !ROUTING_ENABLED.load(Ordering::Relaxed) {
+            return std::ptr::null();
+        }
+        CURRENT_ROUTE.try_with(|current| current.get()).unwrap_or(std::ptr::null())
+    }
+
+    fn is_routed(ptr: *mut u8, layout: &Layout) -> bool {
+        layout.align() <= ROUTED_ALIGNMENT
+            && ROUTED_BLOCKS.load(Ordering::Acquire) != 0
+            && RegistryShard::contains(ptr as usize)
+    }
+}
+
+unsafe impl GlobalAlloc for A5GlobalAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        if layout.align() <= ROUTED_ALIGNMENT {
+            let route = Self::thread_route();
+            if !route.is_null() {
+                let ptr = ((*route).allocate)((*route).ctx, layout.size()) as *mut u8;
+                if !ptr.is_null() {
+                    if RegistryShard::insert(ptr as usize, route) {
+                        ROUTED_BLOCKS.fetch_add(1, Ordering::Release);
+                        return ptr;
+                    }
+                    ((*route).free)((*route).ctx, ptr as *mut c_void, layout.size());
+                }
+                let _ = ROUTE_FALLBACKS.try_with(|fallbacks| fallbacks.set(fallbacks.get() + 1));
+            }
+        }
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        if layout.align() <= ROUTED_ALIGNMENT && ROUTED_BLOCKS.load(Ordering::Acquire) != 0 {
+            let owner = RegistryShard::remove(ptr as usize);
+            if !owner.is_null() {
+                ROUTED_BLOCKS.fetch_sub(1, Ordering::Release);
+                ((*owner).free)((*owner).ctx, ptr as *mut c_void, layout.size());
+                return;
+            }
+        }
+        System.dealloc(ptr, layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        // System blocks outside a routed call grow in place; everything else moves
+        if Self::thread_route().is_null() && !Self::is_routed(ptr, &layout) {
+            return System.realloc(ptr, layout, new_size);
+        }
+        let new_ptr = self.alloc(Layout::from_size_align_unchecked(new_size, layout.align()));
+        if !new_ptr.is_null() {
+            std::ptr::copy_nonoverlapping(ptr, new_ptr, layout.size().min(new_size));
+            self.dealloc(ptr, layout);
+        }
+        new_ptr
+    }
+}
+
+#[global_allocator]
+static GLOBAL: A5GlobalAllocator = A5GlobalAllocator;
+
+/// Returns the message of the last `A5_ERROR` on the calling thread as UTF-8 bytes that are not
+/// NUL-terminated, with their length in `len`. The bytes stay valid until the next failing call on
+/// the same thread.
+#[no_mangle]
+pub extern "C" fn a5_last_error_message(len: *mut usize) -> *const c_char {
+    LAST_ERROR.with(|last| {
+        let last = last.borrow();
+        if !len.is_null() {
+            unsafe { *len = last.len() };
+        }
+        last.as_ptr() as *const c_char
+    })
+}
 
 #[repr(C)]
 pub struct ResultU64 {
     pub value: u64,
-    pub error: *mut std::os::raw::c_char, // null if no error
+    pub error_code: i32, // A5_OK if no error
 }
 
 #[repr(C)]
 pub struct ResultLonLat {
     pub longitude: f64,
     pub latitude: f64,
-    pub error: *mut std::os::raw::c_char, // null if no error
+    pub error_code: i32, // A5_OK if no error
 }
 
 #[repr(C)]
 pub struct ResultSpherical {
     pub theta: f64,
     pub phi: f64,
-    pub error: *mut std::os::raw::c_char,
+    pub error_code: i32, // A5_OK if no error
 }
 
 #[repr(C)]
@@ -42,51 +375,207 @@ impl CellBoundaryOptions {
 
 #[no_mangle]
 pub extern "C" fn a5_lon_lat_to_cell(longitude: f64, latitude: f64, resolution: i32) -> ResultU64 {
-    match a5::lonlat_to_cell(a5::LonLat::new(longitude, latitude), resolution) {
-        Ok(cell) => ResultU64 { value: cell, error: std::ptr::null_mut() },
-        Err(e) => {
-            let err_msg = std::ffi::CString::new(e.to_string()).unwrap();
-            ResultU64 { value: 0, error: err_msg.into_raw() }
+    guarded(|error_code| ResultU64 { value: 0, error_code }, || {
+        match a5::lonlat_to_cell(a5::LonLat::new(longitude, latitude), resolution) {
+            Ok(cell) => ResultU64 { value: cell, error_code: A5_OK },
+            Err(e) => ResultU64 { value: 0, error_code: set_last_error(e.to_string()) },
+        }
+    })
+}
+
+/// The cell of the previous row of a batch. Time-ordered inputs such as vehicle traces put
+/// consecutive rows in the same cell, so before the full lookup (face search, estimate and
+/// containment check of the candidates) the point is tested against this cell alone, which costs a
+/// single projection onto the cell's own dodecahedron face.
+struct LastCell {
+    index: u64,
+    cell: a5::core::utils::A5Cell,
+    resolution: i32,
+    longitude: f64,
+    latitude: f64,
+}
+
+impl LastCell {
+    fn lookup(&self, longitude: f64, latitude: f64, resolution: i32) -> Option<u64> {
+        if resolution != self.resolution {
+            return None;
         }
+        if longitude == self.longitude && latitude == self.latitude {
+            return Some(self.index);
+        }
+        // The distance is positive strictly inside the cell; points on an edge take the full lookup
+        let distance = a5::core::cell::a5cell_contains_point(&self.cell, a5::LonLat::new(longitude, latitude));
+        if distance > 0.0 { Some(self.index) } else { None }
+    }
+}
+
+/// Looks up the cell of a point, trying the cell of the previous row first
+fn lon_lat_to_cell_near(last: &mut Option<LastCell>, longitude: f64, latitude: f64, resolution: i32) -> Option<u64> {
+    if let Some(cell) = last.as_ref().and_then(|l| l.lookup(longitude, latitude, resolution)) {
+        return Some(cell);
     }
+    let index = a5::lonlat_to_cell(a5::LonLat::new(longitude, latitude), resolution).ok()?;
+    // Below the first Hilbert resolution the lookup is a plain estimate without a containment check,
+    // so those cells are not cached
+    *last = if resolution >= 2 {
+        a5::core::serialization::deserialize(index)
+            .ok()
+            .map(|cell| LastCell { index, cell, resolution, longitude, latitude })
+    } else {
+        None
+    };
+    Some(index)
 }
 
+/// Converts `len` longitude/latitude pairs to cells in a single call, writing into the
+/// caller-owned `out` buffer. `validity` is a bitmap of `(len + 63) / 64` words with one bit
+/// per row: rows whose bit is clear on entry are skipped, and rows that fail to convert have
+/// their bit cleared on return. When `constant_resolution` is true only `resolutions[0]` is read.
+/// Each point is first tested against the cell of the previous row, so spatially ordered input
+/// skips most full lookups. Returns the number of rows that failed to convert; a row on which the
+/// a5 crate panics counts as failed.
 #[no_mangle]
-pub extern "C" fn a5_cell_to_parent(index: u64, parent_resolution: i32) -> ResultU64 {
-    match a5::cell_to_parent(index, Some(parent_resolution)) {
-        Ok(cell) => ResultU64 { value: cell, error: std::ptr::null_mut() },
-        Err(e) => {
-            let err_msg = std::ffi::CString::new(e.to_string()).unwrap();
-            ResultU64 { value: 0, error: err_msg.into_raw() }
+pub extern "C" fn a5_lon_lat_to_cell_batch(
+    longitudes: *const f64,
+    latitudes: *const f64,
+    resolutions: *const i32,
+    constant_resolution: bool,
+    out: *mut u64,
+    validity: *mut u64,
+    len: usize,
+) -> usize {
+    if len == 0 || longitudes.is_null() || latitudes.is_null() || resolutions.is_null() || out.is_null() || validity.is_null() {
+        return 0;
+    }
+    let lons = unsafe { std::slice::from_raw_parts(longitudes, len) };
+    let lats = unsafe { std::slice::from_raw_parts(latitudes, len) };
+    let res = unsafe { std::slice::from_raw_parts(resolutions, if constant_resolution { 1 } else { len }) };
+    let out = unsafe { std::slice::from_raw_parts_mut(out, len) };
+    let validity = unsafe { std::slice::from_raw_parts_mut(validity, (len + 63) / 64) };
+
+    let mut failed = 0;
+    let mut last = None;
+    for i in 0..len {
+        let (word, bit) = (i / 64, 1u64 << (i % 64));
+        if validity[word] & bit == 0 {
+            out[i] = 0;
+            continue;
+        }
+        let resolution = if constant_resolution { res[0] } else { res[i] };
+        match guarded_row(|| lon_lat_to_cell_near(&mut last, lons[i], lats[i], resolution)) {
+            Some(cell) => out[i] = cell,
+            None => {
+                // The cached cell may be from before a panic
+                last = None;
+                out[i] = 0;
+                validity[word] &= !bit;
+                failed += 1;
+            }
         }
     }
+    failed
+}
+
+#[no_mangle]
+pub extern "C" fn a5_cell_to_parent(index: u64, parent_resolution: i32) -> ResultU64 {
+    guarded(|error_code| ResultU64 { value: 0, error_code }, || {
+        match a5::cell_to_parent(index, Some(parent_resolution)) {
+            Ok(cell) => ResultU64 { value: cell, error_code: A5_OK },
+            Err(e) => ResultU64 { value: 0, error_code: set_last_error(e.to_string()) },
+        }
+    })
 }
 
 
 #[no_mangle]
 pub extern "C" fn a5_cell_area(resolution: i32) -> f64 {
-    a5::cell_area(resolution)
+    guarded(|_| f64::NAN, || a5::cell_area(resolution))
 }
 
 #[no_mangle]
 pub extern "C" fn a5_cell_to_lon_lat(cell: u64) -> ResultLonLat {
-    match a5::cell_to_lonlat(cell) {
-        Ok(lonlat) => ResultLonLat { longitude: lonlat.longitude.get(), latitude: lonlat.latitude.get(), error: std::ptr::null_mut() },
-        Err(e) => {
-            let err_msg = std::ffi::CString::new(e.to_string()).unwrap();
-            ResultLonLat { longitude: 0.0, latitude: 0.0, error: err_msg.into_raw() }
+    guarded(|error_code| ResultLonLat { longitude: 0.0, latitude: 0.0, error_code }, || {
+        match a5::cell_to_lonlat(cell) {
+            Ok(lonlat) => ResultLonLat { longitude: lonlat.longitude.get(), latitude: lonlat.latitude.get(), error_code: A5_OK },
+            Err(e) => ResultLonLat { longitude: 0.0, latitude: 0.0, error_code: set_last_error(e.to_string()) },
         }
+    })
+}
+
+/// Writes the result of `convert` for every set bit of `validity` as an interleaved pair into `out`,
+/// which has room for `2 * len` doubles. Same validity contract as `a5_lon_lat_to_cell_batch`.
+/// Repeated cells in consecutive rows, common in sorted or tile-grouped input, are converted once.
+/// A row on which the a5 crate panics counts as failed.
+fn cells_to_pairs_batch(
+    cells: *const u64,
+    out: *mut f64,
+    validity: *mut u64,
+    len: usize,
+    convert: impl Fn(u64) -> Option<(f64, f64)>,
+) -> usize {
+    if len == 0 || cells.is_null() || out.is_null() || validity.is_null() {
+        return 0;
     }
+    let cells = unsafe { std::slice::from_raw_parts(cells, len) };
+    let out = unsafe { std::slice::from_raw_parts_mut(out, 2 * len) };
+    let validity = unsafe { std::slice::from_raw_parts_mut(validity, (len + 63) / 64) };
+
+    let mut failed = 0;
+    let mut last: Option<(u64, (f64, f64))> = None;
+    for i in 0..len {
+        let (word, bit) = (i / 64, 1u64 << (i % 64));
+        if validity[word] & bit == 0 {
+            out[2 * i] = 0.0;
+            out[2 * i + 1] = 0.0;
+            continue;
+        }
+        let pair = match last {
+            Some((cell, pair)) if cell == cells[i] => Some(pair),
+            _ => guarded_row(|| convert(cells[i])),
+        };
+        match pair {
+            Some(pair) => {
+                out[2 * i] = pair.0;
+                out[2 * i + 1] = pair.1;
+                last = Some((cells[i], pair));
+            }
+            None => {
+                out[2 * i] = 0.0;
+                out[2 * i + 1] = 0.0;
+                validity[word] &= !bit;
+                failed += 1;
+            }
+        }
+    }
+    failed
+}
+
+/// Writes the [longitude, latitude] center of `len` cells into `out` in a single call.
+/// Returns the number of cells that failed to convert; see `cells_to_pairs_batch`.
+#[no_mangle]
+pub extern "C" fn a5_cell_to_lon_lat_batch(cells: *const u64, out: *mut f64, validity: *mut u64, len: usize) -> usize {
+    cells_to_pairs_batch(cells, out, validity, len, |cell| {
+        a5::cell_to_lonlat(cell).ok().map(|ll| (ll.longitude.get(), ll.latitude.get()))
+    })
+}
+
+/// Writes the [theta, phi] center of `len` cells into `out` in a single call.
+/// Returns the number of cells that failed to convert; see `cells_to_pairs_batch`.
+#[no_mangle]
+pub extern "C" fn a5_cell_to_spherical_batch(cells: *const u64, out: *mut f64, validity: *mut u64, len: usize) -> usize {
+    cells_to_pairs_batch(cells, out, validity, len, |cell| {
+        a5::cell_to_spherical(cell).ok().map(|sph| (sph.theta.get(), sph.phi.get()))
+    })
 }
 
 #[no_mangle]
 pub extern "C" fn a5_get_num_cells(resolution: i32) -> u64 {
-    a5::get_num_cells(resolution)
+    guarded(|_| 0, || a5::get_num_cells(resolution))
 }
 
 #[no_mangle]
 pub extern "C" fn a5_get_resolution(index: u64) -> i32 {
-    a5::get_resolution(index)
+    guarded(|_| -1, || a5::get_resolution(index))
 }
 
 #[repr(C)]
@@ -96,66 +585,74 @@ pub struct LonLatDegrees {
     pub lat: f64,
 }
 
-#[repr(C)]
-pub struct LonLatDegreesArray {
-    pub data: *mut LonLatDegrees,        // pointer to array of LonLatDegrees
-    pub len: usize,               // length of the array
-    pub error: *mut std::os::raw::c_char, // null if no error
-}
-
 #[repr(C)]
 pub struct CellArray {
     pub data: *mut u64,        // pointer to array of cell IDs
     pub len: usize,               // length of the array
-    pub error: *mut std::os::raw::c_char, // null if no error
+    pub error_code: i32,          // A5_OK if no error
 }
 
 
-pub fn vec_result_to_c(result: Result<Vec<a5::LonLat>, String>) -> LonLatDegreesArray {
+pub fn cell_vec_result_to_c(result: Result<Vec<u64>, String>) -> CellArray {
     match result {
         Ok(vec) => {
-            let degree_vec: Vec<LonLatDegrees> = vec.into_iter().map(|ll| LonLatDegrees { lon: ll.longitude.get(), lat: ll.latitude.get() }).collect();
-            let len = degree_vec.len();
-
-            let mut boxed_slice = degree_vec.into_boxed_slice(); // heap allocation
+            let mut boxed_slice = vec.into_boxed_slice(); // heap allocation
             let data_ptr = boxed_slice.as_mut_ptr();
+            let len = boxed_slice.len();
             std::mem::forget(boxed_slice); // prevent Rust from freeing it
-            LonLatDegreesArray { data: data_ptr, len, error: std::ptr::null_mut() }
-        }
-        Err(e) => {
-            let c_str = CString::new(e).unwrap();
-            LonLatDegreesArray { data: std::ptr::null_mut(), len: 0, error: c_str.into_raw() }
+            CellArray { data: data_ptr, len, error_code: A5_OK }
         }
+        Err(e) => CellArray { data: std::ptr::null_mut(), len: 0, error_code: set_last_error(e) },
     }
 }
 
-pub fn cell_vec_result_to_c(result: Result<Vec<u64>, String>) -> CellArray {
+/// Callback through which the caller provides the output buffer for a variable-length cell
+/// result. It is called at most once per call with the number of cells produced and must return
+/// a buffer with room for at least `len` cells, or null if the buffer could not be allocated.
+pub type CellSink = extern "C" fn(ctx: *mut c_void, len: usize) -> *mut u64;
+
+/// Callback through which the caller provides the output buffer for a variable-length list of
+/// points. Same contract as `CellSink`, with room for `len` lon/lat pairs.
+pub type LonLatSink = extern "C" fn(ctx: *mut c_void, len: usize) -> *mut LonLatDegrees;
+
+/// Converts the points of `result` to degrees directly into the buffer handed out by `sink`.
+/// Returns A5_OK on success or an error code.
+pub fn lonlat_vec_result_to_sink(result: Result<Vec<a5::LonLat>, String>, sink: LonLatSink, ctx: *mut c_void) -> i32 {
     match result {
         Ok(vec) => {
-            let mut boxed_slice = vec.into_boxed_slice(); // heap allocation
-            let data_ptr = boxed_slice.as_mut_ptr();
-            let len = boxed_slice.len();
-            std::mem::forget(boxed_slice); // prevent Rust from freeing it
-            CellArray { data: data_ptr, len, error: std::ptr::null_mut() }
-        }
-        Err(e) => {
-            let c_str = CString::new(e).unwrap();
-            CellArray { data: std::ptr::null_mut(), len: 0, error: c_str.into_raw() }
+            if vec.is_empty() {
+                return A5_OK;
+            }
+            let dest = sink(ctx, vec.len());
+            if dest.is_null() {
+                return A5_ERROR_ALLOCATION;
+            }
+            let dest = unsafe { std::slice::from_raw_parts_mut(dest, vec.len()) };
+            for (out, ll) in dest.iter_mut().zip(vec.iter()) {
+                *out = LonLatDegrees { lon: ll.longitude.get(), lat: ll.latitude.get() };
+            }
+            A5_OK
         }
+        Err(e) => set_last_error(e),
     }
 }
 
-
-#[no_mangle]
-pub extern "C" fn a5_free_lonlatdegrees_array(arr: LonLatDegreesArray) {
-    if !arr.data.is_null() {
-        unsafe {
-            // reconstruct the boxed slice and drop it
-            let _ = Box::from_raw(std::slice::from_raw_parts_mut(arr.data, arr.len));
+/// Copies the cells of `result` into the buffer handed out by `sink`.
+/// Returns A5_OK on success or an error code.
+pub fn cell_vec_result_to_sink(result: Result<Vec<u64>, String>, sink: CellSink, ctx: *mut c_void) -> i32 {
+    match result {
+        Ok(vec) => {
+            if vec.is_empty() {
+                return A5_OK;
+            }
+            let dest = sink(ctx, vec.len());
+            if dest.is_null() {
+                return A5_ERROR_ALLOCATION;
+            }
+            unsafe { std::ptr::copy_nonoverlapping(vec.as_ptr(), dest, vec.len()) };
+            A5_OK
         }
-    }
-    if !arr.error.is_null() {
-        unsafe { drop(CString::from_raw(arr.error)); }
+        Err(e) => set_last_error(e),
     }
 }
 
@@ -167,113 +664,95 @@ pub extern "C" fn a5_free_cell_array(arr: CellArray) {
             let _ = Box::from_raw(std::slice::from_raw_parts_mut(arr.data, arr.len));
         }
     }
-    if !arr.error.is_null() {
-        unsafe { drop(CString::from_raw(arr.error)); }
-    }
 }
 
 #[no_mangle]
-pub extern "C" fn a5_cell_to_boundary(cell_id: u64, options: CellBoundaryOptions) -> LonLatDegreesArray {
-    vec_result_to_c(a5::cell_to_boundary(cell_id, Some(a5::core::cell::CellToBoundaryOptions { closed_ring: options.closed_ring, segments: options.segments() })))
+pub extern "C" fn a5_cell_to_boundary_into(cell_id: u64, options: CellBoundaryOptions, sink: LonLatSink, ctx: *mut c_void) -> i32 {
+    guarded(|error_code| error_code, || {
+        lonlat_vec_result_to_sink(a5::cell_to_boundary(cell_id, Some(a5::core::cell::CellToBoundaryOptions { closed_ring: options.closed_ring, segments: options.segments() })), sink, ctx)
+    })
 }
 
 #[no_mangle]
-pub extern "C" fn a5_cell_to_children(index: u64, child_resolution: i32) -> CellArray {
-    match child_resolution {
+pub extern "C" fn a5_cell_to_children_into(index: u64, child_resolution: i32, sink: CellSink, ctx: *mut c_void) -> i32 {
+    guarded(|error_code| error_code, || match child_resolution {
         r if r >= 0 && r < 31 => {
-            cell_vec_result_to_c(a5::cell_to_children(index, Some(child_resolution)))
+            cell_vec_result_to_sink(a5::cell_to_children(index, Some(child_resolution)), sink, ctx)
         }
-        _ => cell_vec_result_to_c(a5::cell_to_children(index, None)),
-    }
+        _ => cell_vec_result_to_sink(a5::cell_to_children(index, None), sink, ctx),
+    })
 }
 
 #[no_mangle]
 pub extern "C" fn a5_get_res0_cells() -> CellArray {
-    cell_vec_result_to_c(a5::get_res0_cells())
+    guarded(|error_code| CellArray { data: std::ptr::null_mut(), len: 0, error_code }, || {
+        cell_vec_result_to_c(a5::get_res0_cells())
+    })
 }
 
 #[no_mangle]
-pub extern "C" fn a5_compact(cells: *const u64, len: usize) -> CellArray {
+pub extern "C" fn a5_compact_into(cells: *const u64, len: usize, sink: CellSink, ctx: *mut c_void) -> i32 {
     if cells.is_null() || len == 0 {
-        return CellArray { data: std::ptr::null_mut(), len: 0, error: std::ptr::null_mut() };
+        return A5_OK;
     }
     let cell_slice = unsafe { std::slice::from_raw_parts(cells, len) };
-    cell_vec_result_to_c(a5::compact(cell_slice))
+    guarded(|error_code| error_code, || cell_vec_result_to_sink(a5::compact(cell_slice), sink, ctx))
 }
 
 #[no_mangle]
-pub extern "C" fn a5_uncompact(cells: *const u64, len: usize, target_resolution: i32) -> CellArray {
+pub extern "C" fn a5_uncompact_into(cells: *const u64, len: usize, target_resolution: i32, sink: CellSink, ctx: *mut c_void) -> i32 {
     if cells.is_null() || len == 0 {
-        return CellArray { data: std::ptr::null_mut(), len: 0, error: std::ptr::null_mut() };
+        return A5_OK;
     }
     let cell_slice = unsafe { std::slice::from_raw_parts(cells, len) };
-    cell_vec_result_to_c(a5::uncompact(cell_slice, target_resolution))
+    guarded(|error_code| error_code, || cell_vec_result_to_sink(a5::uncompact(cell_slice, target_resolution), sink, ctx))
 }
 
+/// Parses the `len` bytes at `hex`, which need not be NUL-terminated. The extension decodes
+/// well-formed cell strings itself and only calls this for the rest, so errors are reported with
+/// the crate's message.
 #[no_mangle]
-pub extern "C" fn a5_free_string(ptr: *mut std::os::raw::c_char) {
-    if !ptr.is_null() {
-        unsafe { drop(CString::from_raw(ptr)); }
-    }
-}
-
-#[no_mangle]
-pub extern "C" fn a5_hex_to_u64(hex: *const std::os::raw::c_char) -> ResultU64 {
+pub extern "C" fn a5_hex_to_u64(hex: *const c_char, len: usize) -> ResultU64 {
     if hex.is_null() {
-        let err_msg = CString::new("hex string is null").unwrap();
-        return ResultU64 { value: 0, error: err_msg.into_raw() };
+        return ResultU64 { value: 0, error_code: set_last_error("hex string is null".to_string()) };
     }
-    let c_str = unsafe { CStr::from_ptr(hex) };
-    let hex_str = match c_str.to_str() {
+    let bytes = unsafe { std::slice::from_raw_parts(hex as *const u8, len) };
+    let hex_str = match std::str::from_utf8(bytes) {
         Ok(s) => s,
-        Err(e) => {
-            let err_msg = CString::new(e.to_string()).unwrap();
-            return ResultU64 { value: 0, error: err_msg.into_raw() };
-        }
+        Err(e) => return ResultU64 { value: 0, error_code: set_last_error(e.to_string()) },
     };
-    match a5::hex_to_u64(hex_str) {
-        Ok(value) => ResultU64 { value, error: std::ptr::null_mut() },
-        Err(e) => {
-            let err_msg = CString::new(e.to_string()).unwrap();
-            ResultU64 { value: 0, error: err_msg.into_raw() }
-        }
-    }
-}
-
-#[no_mangle]
-pub extern "C" fn a5_u64_to_hex(value: u64) -> *mut std::os::raw::c_char {
-    let hex = a5::u64_to_hex(value);
-    CString::new(hex).unwrap().into_raw()
+    guarded(|error_code| ResultU64 { value: 0, error_code }, || match a5::hex_to_u64(hex_str) {
+        Ok(value) => ResultU64 { value, error_code: A5_OK },
+        Err(e) => ResultU64 { value: 0, error_code: set_last_error(e.to_string()) },
+    })
 }
 
 #[no_mangle]
 pub extern "C" fn a5_get_num_children(parent_res: i32, child_res: i32) -> usize {
-    a5::get_num_children(parent_res, child_res)
+    guarded(|_| 0, || a5::get_num_children(parent_res, child_res))
 }
 
 #[no_mangle]
 pub extern "C" fn a5_cell_to_spherical(cell: u64) -> ResultSpherical {
-    match a5::cell_to_spherical(cell) {
-        Ok(sph) => ResultSpherical { theta: sph.theta.get(), phi: sph.phi.get(), error: std::ptr::null_mut() },
-        Err(e) => {
-            let err_msg = CString::new(e.to_string()).unwrap();
-            ResultSpherical { theta: 0.0, phi: 0.0, error: err_msg.into_raw() }
+    guarded(|error_code| ResultSpherical { theta: 0.0, phi: 0.0, error_code }, || {
+        match a5::cell_to_spherical(cell) {
+            Ok(sph) => ResultSpherical { theta: sph.theta.get(), phi: sph.phi.get(), error_code: A5_OK },
+            Err(e) => ResultSpherical { theta: 0.0, phi: 0.0, error_code: set_last_error(e.to_string()) },
         }
-    }
+    })
 }
 
 #[no_mangle]
-pub extern "C" fn a5_spherical_cap(cell_id: u64, radius: f64) -> CellArray {
-    cell_vec_result_to_c(a5::spherical_cap(cell_id, radius))
+pub extern "C" fn a5_spherical_cap_into(cell_id: u64, radius: f64, sink: CellSink, ctx: *mut c_void) -> i32 {
+    guarded(|error_code| error_code, || cell_vec_result_to_sink(a5::spherical_cap(cell_id, radius), sink, ctx))
 }
 
 #[no_mangle]
-pub extern "C" fn a5_grid_disk(cell_id: u64, k: usize) -> CellArray {
-    cell_vec_result_to_c(a5::grid_disk(cell_id, k))
+pub extern "C" fn a5_grid_disk_into(cell_id: u64, k: usize, sink: CellSink, ctx: *mut c_void) -> i32 {
+    guarded(|error_code| error_code, || cell_vec_result_to_sink(a5::grid_disk(cell_id, k), sink, ctx))
 }
 
 #[no_mangle]
-pub extern "C" fn a5_grid_disk_vertex(cell_id: u64, k: usize) -> CellArray {
-    cell_vec_result_to_c(a5::grid_disk_vertex(cell_id, k))
+pub extern "C" fn a5_grid_disk_vertex_into(cell_id: u64, k: usize, sink: CellSink, ctx: *mut c_void) -> i32 {
+    guarded(|error_code| error_code, || cell_vec_result_to_sink(a5::grid_disk_vertex(cell_id, k), sink, ctx))
 }
-
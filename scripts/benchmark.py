@@ -0,0 +1,208 @@
+#!/usr/bin/python3
+
+"""
+Runs the benchmarks under benchmark/a5 with DuckDB's benchmark runner, reports throughput and peak
+memory per benchmark, and compares them against a baseline: either a second runner built from another
+commit, run on the same machine in alternation with this one, or results stored in a CSV file.
+
+Each benchmark is run in its own runner process so its peak resident set size (which includes the
+allocations made by the Rust crate) can be attributed to it.
+"""
+
+import argparse
+import csv
+import os
+import re
+import statistics
+import subprocess
+import sys
+from pathlib import Path
+
+BENCHMARK_DIR = Path("benchmark/a5")
+ROWS_PATTERN = re.compile(r"^#\s*rows:\s*(\d+)\s*$", re.MULTILINE)
+FIELDS = ["benchmark", "rows", "median_seconds", "rows_per_second", "peak_rss_bytes"]
+
+
+def benchmark_rows(path: Path) -> int:
+    """
+    Read the number of rows a benchmark processes from its `# rows:` header.
+
+    Args:
+        path (Path): Benchmark file.
+
+    Returns:
+        int: Rows processed by one run of the benchmark.
+    """
+    match = ROWS_PATTERN.search(path.read_text())
+    if not match:
+        raise ValueError(f"{path} has no '# rows: N' header")
+    return int(match.group(1))
+
+
+def run_benchmark(runner: str, path: Path) -> tuple:
+    """
+    Run a single benchmark and collect its timings and the runner's peak memory.
+
+    Args:
+        runner (str): Path to the benchmark_runner binary.
+        path (Path): Benchmark file.
+
+    Returns:
+        tuple: (median seconds per run, peak resident set size in bytes)
+    """
+    process = subprocess.Popen([runner, str(path)], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    output = process.stdout.read()
+    _, status, usage = os.wait4(process.pid, 0)
+    process.returncode = os.waitstatus_to_exitcode(status)
+    if process.returncode != 0:
+        raise RuntimeError(f"{path} failed:\n{output}")
+
+    timings = []
+    for line in output.splitlines():
+        parts = line.split("\t")
+        if len(parts) == 3 and parts[0] == str(path):
+            timings.append(float(parts[2]))
+    if not timings:
+        raise RuntimeError(f"{path} produced no timings:\n{output}")
+
+    # ru_maxrss is reported in kilobytes on Linux and in bytes on macOS
+    peak_rss = usage.ru_maxrss if sys.platform == "darwin" else usage.ru_maxrss * 1024
+    return statistics.median(timings), peak_rss
+
+
+def read_results(path: Path) -> dict:
+    with path.open() as f:
+        return {row["benchmark"]: row for row in csv.DictReader(f)}
+
+
+def write_results(path: Path, results: list) -> None:
+    with path.open("w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=FIELDS)
+        writer.writeheader()
+        writer.writerows(results)
+
+
+def measure(runner: str, path: Path, rows: int) -> dict:
+    """
+    Run one benchmark and describe its result as a CSV row.
+
+    Args:
+        runner (str): Path to the benchmark_runner binary.
+        path (Path): Benchmark file.
+        rows (int): Rows processed by one run of the benchmark.
+
+    Returns:
+        dict: Row with the fields in FIELDS.
+    """
+    median, peak_rss = run_benchmark(runner, path)
+    return {
+        "benchmark": str(path),
+        "rows": rows,
+        "median_seconds": f"{median:.6f}",
+        "rows_per_second": f"{rows / median:.0f}",
+        "peak_rss_bytes": peak_rss,
+    }
+
+
+def compare(results: list, baseline: dict, max_slowdown: float, max_memory_growth: float) -> list:
+    """
+    Compare results against the baseline.
+
+    Args:
+        results (list): Rows produced by this run.
+        baseline (dict): Baseline rows keyed by benchmark path.
+        max_slowdown (float): Allowed relative drop in rows per second.
+        max_memory_growth (float): Allowed relative growth in peak memory.
+
+    Returns:
+        list: Descriptions of the regressions found.
+    """
+    regressions = []
+    for result in results:
+        reference = baseline.get(result["benchmark"])
+        if reference is None:
+            continue
+        old_rate = float(reference["rows_per_second"])
+        new_rate = float(result["rows_per_second"])
+        if new_rate < old_rate * (1 - max_slowdown):
+            regressions.append(
+                f"{result['benchmark']}: {new_rate:,.0f} rows/s vs {old_rate:,.0f} rows/s in the baseline"
+            )
+        old_rss = int(reference["peak_rss_bytes"])
+        new_rss = int(result["peak_rss_bytes"])
+        if new_rss > old_rss * (1 + max_memory_growth):
+            regressions.append(
+                f"{result['benchmark']}: peak memory {new_rss:,} bytes vs {old_rss:,} bytes in the baseline"
+            )
+    return regressions
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Run the a5 benchmarks and compare them against a baseline")
+    parser.add_argument("--runner", default="build/release/benchmark/benchmark_runner")
+    parser.add_argument("--pattern", default=".*", help="Regular expression selecting benchmark file names")
+    parser.add_argument("--baseline", default=str(BENCHMARK_DIR / "baseline.csv"))
+    parser.add_argument(
+        "--baseline-runner",
+        help="Runner built from the reference commit; each benchmark runs with it right after this runner, "
+        "and the comparison is against those runs instead of the stored baseline",
+    )
+    parser.add_argument("--output", default="benchmark_results.csv")
+    parser.add_argument("--baseline-output", default="benchmark_baseline_results.csv")
+    parser.add_argument("--update-baseline", action="store_true", help="Store this run as the new baseline")
+    parser.add_argument("--max-slowdown", type=float, default=0.15)
+    parser.add_argument("--max-memory-growth", type=float, default=0.25)
+    args = parser.parse_args()
+
+    if args.baseline_runner and not Path(args.baseline_runner).exists():
+        raise FileNotFoundError(f"baseline runner {args.baseline_runner} does not exist")
+
+    pattern = re.compile(args.pattern)
+    results = []
+    baseline_results = []
+    for path in sorted(BENCHMARK_DIR.glob("*.benchmark")):
+        if not pattern.search(path.name):
+            continue
+        rows = benchmark_rows(path)
+        result = measure(args.runner, path, rows)
+        results.append(result)
+        rate = int(result["rows_per_second"])
+        line = f"{path.name:<40} {rate:>16,} rows/s {result['peak_rss_bytes'] / (1 << 20):>10,.1f} MiB peak"
+        if args.baseline_runner:
+            # Benchmarks added since the reference commit can use functions its runner does not have
+            try:
+                reference = measure(args.baseline_runner, path, rows)
+            except RuntimeError:
+                print(f"{line}   (not runnable on the baseline)")
+                continue
+            baseline_results.append(reference)
+            change = int(result["rows_per_second"]) / int(reference["rows_per_second"]) - 1
+            line += f" {change:>+8.1%} vs baseline"
+        print(line)
+
+    write_results(Path(args.output), results)
+    if args.baseline_runner:
+        write_results(Path(args.baseline_output), baseline_results)
+        baseline = {row["benchmark"]: row for row in baseline_results}
+        regressions = compare(results, baseline, args.max_slowdown, args.max_memory_growth)
+        for regression in regressions:
+            print(f"REGRESSION {regression}")
+        return 1 if regressions else 0
+
+    baseline_path = Path(args.baseline)
+    if args.update_baseline:
+        write_results(baseline_path, results)
+        print(f"Baseline written to {baseline_path}")
+        return 0
+    if not baseline_path.exists():
+        print(f"No baseline at {baseline_path}; run with --update-baseline on the reference machine to create one")
+        return 0
+
+    regressions = compare(results, read_results(baseline_path), args.max_slowdown, args.max_memory_growth)
+    for regression in regressions:
+        print(f"REGRESSION {regression}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
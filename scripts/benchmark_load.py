@@ -0,0 +1,55 @@
+#!/usr/bin/python3
+
+"""
+Measures the latency of `LOAD a5`: each sample starts a fresh DuckDB shell that loads the extension,
+and the time of a shell that only runs `SELECT 1` is subtracted so process startup is not counted.
+"""
+
+import argparse
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+
+def run_shell(duckdb: str, sql: str) -> float:
+    """
+    Run one statement in a new DuckDB shell.
+
+    Args:
+        duckdb (str): Path to the DuckDB shell.
+        sql (str): Statement to run.
+
+    Returns:
+        float: Wall-clock seconds taken by the shell process.
+    """
+    env = dict(os.environ, QUERY_FARM_TELEMETRY_OPT_OUT="1")
+    start = time.perf_counter()
+    subprocess.run([duckdb, "-unsigned", "-c", sql], env=env, check=True, stdout=subprocess.DEVNULL)
+    return time.perf_counter() - start
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Measure the latency of loading the a5 extension")
+    parser.add_argument("--duckdb", default="build/release/duckdb")
+    parser.add_argument("--extension", default="build/release/extension/a5/a5.duckdb_extension")
+    parser.add_argument("--runs", type=int, default=30)
+    args = parser.parse_args()
+
+    load = f"LOAD '{args.extension}'"
+    # Warm the page cache so the first sample does not pay for reading the binaries
+    run_shell(args.duckdb, load)
+
+    baseline = [run_shell(args.duckdb, "SELECT 1") for _ in range(args.runs)]
+    loaded = [run_shell(args.duckdb, f"{load}; SELECT 1") for _ in range(args.runs)]
+
+    startup = statistics.median(baseline)
+    latency = statistics.median(loaded) - startup
+    print(f"shell startup      {startup * 1000:>8.2f} ms")
+    print(f"LOAD a5 (median)   {latency * 1000:>8.2f} ms over {args.runs} runs")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
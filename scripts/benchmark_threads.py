@@ -0,0 +1,142 @@
+#!/usr/bin/python3
+
+"""
+Measures how a5_lonlat_to_cell and a5_cell_to_boundary scale with DuckDB's thread count, with the Rust
+library allocating from the system allocator and from DuckDB's buffer allocator (a5_duckdb_allocator).
+
+Each configuration runs in its own DuckDB shell so its peak resident set size can be attributed to it.
+The memory DuckDB tracks for its buffer allocator is read before and after the queries; with
+a5_duckdb_allocator it must be back where it started, showing every block the Rust library took was
+counted and returned.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+QUERIES = {
+    "a5_lonlat_to_cell": "SELECT sum(a5_lonlat_to_cell(lon, lat, 15)) FROM points",
+    "a5_cell_to_boundary": "SELECT sum(len(a5_cell_to_boundary(a5_lonlat_to_cell(lon, lat, 12)))) FROM points",
+}
+TIMER_PATTERN = re.compile(r"Run Time \(s\): real ([0-9.]+)")
+TRACKED_PATTERN = re.compile(r"^tracked_bytes\s*=\s*(\d+)$", re.MULTILINE)
+
+
+def run_configuration(duckdb: str, extension: str, rows: int, threads: int, duckdb_allocator: bool, runs: int):
+    """
+    Time every query at one thread count in a new DuckDB shell.
+
+    Args:
+        duckdb (str): Path to the DuckDB shell.
+        extension (str): Path to the a5 extension.
+        rows (int): Number of points the queries read.
+        threads (int): Value of the threads setting.
+        duckdb_allocator (bool): Value of the a5_duckdb_allocator setting.
+        runs (int): Timed runs per query; the fastest is kept.
+
+    Returns:
+        tuple: (seconds per query name, peak resident set size in bytes, change in tracked bytes)
+    """
+    tracked = "SELECT coalesce(sum(memory_usage_bytes), 0) AS tracked_bytes FROM duckdb_memory() WHERE tag = 'ALLOCATOR';"
+    script = [
+        f"LOAD '{extension}';",
+        f"SET threads = {threads};",
+        f"SET a5_duckdb_allocator = {str(duckdb_allocator).lower()};",
+        "SELECT setseed(0.42);",
+        "CREATE TABLE points AS SELECT random() * 360 - 180 AS lon, degrees(asin(random() * 2 - 1)) AS lat "
+        f"FROM range({rows});",
+        ".mode line",
+        tracked,
+        ".timer on",
+    ]
+    for sql in QUERIES.values():
+        script += [f"{sql};"] * runs
+    script += [".timer off", tracked]
+
+    env = dict(os.environ, QUERY_FARM_TELEMETRY_OPT_OUT="1")
+    process = subprocess.Popen(
+        [duckdb, "-unsigned"],
+        stdin=subprocess.PIPE,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.STDOUT,
+        text=True,
+        env=env,
+    )
+    process.stdin.write("\n".join(script) + "\n")
+    process.stdin.close()
+    output = process.stdout.read()
+    _, status, usage = os.wait4(process.pid, 0)
+    process.returncode = os.waitstatus_to_exitcode(status)
+    if process.returncode != 0:
+        raise RuntimeError(f"threads={threads} failed:\n{output}")
+
+    timings = [float(t) for t in TIMER_PATTERN.findall(output)]
+    if len(timings) != runs * len(QUERIES):
+        raise RuntimeError(f"threads={threads} produced {len(timings)} timings:\n{output}")
+    seconds = {name: min(timings[i * runs : (i + 1) * runs]) for i, name in enumerate(QUERIES)}
+
+    tracked_bytes = [int(v) for v in TRACKED_PATTERN.findall(output)]
+    tracked_growth = tracked_bytes[-1] - tracked_bytes[0] if len(tracked_bytes) == 2 else 0
+    # ru_maxrss is reported in kilobytes on Linux and in bytes on macOS
+    peak_rss = usage.ru_maxrss if sys.platform == "darwin" else usage.ru_maxrss * 1024
+    return seconds, peak_rss, tracked_growth
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Measure the thread scaling of the a5 scalar functions")
+    parser.add_argument("--duckdb", default="build/release/duckdb")
+    parser.add_argument("--extension", default="build/release/extension/a5/a5.duckdb_extension")
+    parser.add_argument("--rows", type=int, default=4_000_000)
+    parser.add_argument("--max-threads", type=int, default=32)
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument(
+        "--min-efficiency",
+        type=float,
+        default=0.7,
+        help="Fail when the speedup at the largest thread count divided by that count falls below this",
+    )
+    args = parser.parse_args()
+
+    thread_counts = [1]
+    while thread_counts[-1] * 2 <= args.max_threads:
+        thread_counts.append(thread_counts[-1] * 2)
+    if thread_counts[-1] != args.max_threads:
+        thread_counts.append(args.max_threads)
+    cores = os.cpu_count() or 1
+    if args.max_threads > cores:
+        print(f"note: {cores} cores available; efficiency above {cores} threads is not expected to hold")
+
+    failures = []
+    for duckdb_allocator in (False, True):
+        print(f"\na5_duckdb_allocator = {str(duckdb_allocator).lower()}")
+        print(f"{'threads':>7} {'function':<22} {'rows/s':>16} {'speedup':>8} {'efficiency':>10} {'peak MiB':>9}")
+        single = None
+        for threads in thread_counts:
+            seconds, peak_rss, tracked_growth = run_configuration(
+                args.duckdb, args.extension, args.rows, threads, duckdb_allocator, args.runs
+            )
+            single = single or seconds
+            for name in QUERIES:
+                speedup = single[name] / seconds[name]
+                efficiency = speedup / threads
+                print(
+                    f"{threads:>7} {name:<22} {args.rows / seconds[name]:>16,.0f} {speedup:>8.2f} "
+                    f"{efficiency:>10.2f} {peak_rss / (1 << 20):>9,.1f}"
+                )
+                if threads == thread_counts[-1] and threads <= cores and efficiency < args.min_efficiency:
+                    failures.append(
+                        f"{name} with a5_duckdb_allocator={str(duckdb_allocator).lower()}: efficiency "
+                        f"{efficiency:.2f} at {threads} threads"
+                    )
+            if duckdb_allocator and tracked_growth != 0:
+                failures.append(f"{tracked_growth:,} bytes tracked by DuckDB were not returned at {threads} threads")
+
+    for failure in failures:
+        print(f"REGRESSION {failure}")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,114 @@
+#include "a5_common.hpp"
+#include "a5_cell_set.hpp"
+#include "duckdb/function/aggregate_function.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/parser/parsed_data/create_aggregate_function_info.hpp"
+
+namespace duckdb {
+
+// Cells buffered by a partial state before it compacts them locally
+static constexpr idx_t A5_COMPACT_AGG_MIN_BUFFER = 65536;
+
+struct A5CompactAggState {
+	vector<uint64_t> *cells;
+	// Size of `cells` right after the last compaction
+	idx_t compacted_size;
+};
+
+struct A5CompactAggFunction {
+	template <class STATE>
+	static void Initialize(STATE &state) {
+		state.cells = nullptr;
+		state.compacted_size = 0;
+	}
+
+	template <class STATE>
+	static void Destroy(STATE &state, AggregateInputData &aggr_input_data) {
+		delete state.cells;
+		state.cells = nullptr;
+	}
+
+	static bool IgnoreNull() {
+		return true;
+	}
+
+	template <class STATE>
+	static void Compact(STATE &state) {
+		A5CompactCellSet(*state.cells, "a5_compact_agg");
+		state.compacted_size = state.cells->size();
+	}
+
+	template <class INPUT_TYPE, class STATE, class OP>
+	static void Operation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &unary_input) {
+		if (!state.cells) {
+			state.cells = new vector<uint64_t>();
+		}
+		state.cells->push_back(input);
+		// Compact once the buffer has grown well past the last compacted result, so each thread only
+		// ever holds a bounded amount of uncompacted input
+		if (state.cells->size() >= MaxValue<idx_t>(A5_COMPACT_AGG_MIN_BUFFER, 2 * state.compacted_size)) {
+			Compact(state);
+		}
+	}
+
+	template <class INPUT_TYPE, class STATE, class OP>
+	static void ConstantOperation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &unary_input,
+	                              idx_t count) {
+		// Repeating a cell does not change the compacted set
+		Operation<INPUT_TYPE, STATE, OP>(state, input, unary_input);
+	}
+
+	template <class STATE, class OP>
+	static void Combine(const STATE &source, STATE &target, AggregateInputData &aggr_input_data) {
+		if (!source.cells || source.cells->empty()) {
+			return;
+		}
+		if (!target.cells) {
+			target.cells = new vector<uint64_t>();
+		}
+		target.cells->insert(target.cells->end(), source.cells->begin(), source.cells->end());
+		Compact(target);
+	}
+
+	template <class T, class STATE>
+	static void Finalize(STATE &state, T &target, AggregateFinalizeData &finalize_data) {
+		if (!state.cells) {
+			finalize_data.ReturnNull();
+			return;
+		}
+		if (state.cells->size() != state.compacted_size) {
+			Compact(state);
+		}
+
+		auto &result = finalize_data.result;
+		auto offset = ListVector::GetListSize(result);
+		auto length = state.cells->size();
+		ListVector::Reserve(result, offset + length);
+		auto child_data = FlatVector::GetData<uint64_t>(ListVector::GetEntry(result));
+		memcpy(child_data + offset, state.cells->data(), length * sizeof(uint64_t));
+		ListVector::SetListSize(result, offset + length);
+		target = list_entry_t {offset, length};
+	}
+};
+
+void RegisterA5AggregateFunctions(ExtensionLoader &loader) {
+	// a5_compact_agg: Compacts all cells of a group
+	{
+		auto func = AggregateFunction::UnaryAggregateDestructor<A5CompactAggState, uint64_t, list_entry_t,
+		                                                        A5CompactAggFunction>(
+		    LogicalType::UBIGINT, LogicalType::LIST(LogicalType::UBIGINT));
+		func.name = "a5_compact_agg";
+		CreateAggregateFunctionInfo info(func);
+		FunctionDescription desc;
+		desc.description = "Compacts all A5 cells of a group into the smallest equivalent set of cells, merging "
+		                   "complete sets of siblings into their parents";
+		desc.parameter_names = {"cell"};
+		desc.parameter_types = {LogicalType::UBIGINT};
+		desc.examples = {"SELECT a5_compact_agg(cell) FROM a5_children_scan(a5_lonlat_to_cell(-122.4, 37.8, 5), 8)"};
+		desc.categories = {"a5", "geospatial"};
+		info.descriptions.push_back(std::move(desc));
+		loader.RegisterFunction(std::move(info));
+	}
+}
+
+} // namespace duckdb
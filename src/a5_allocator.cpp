@@ -0,0 +1,153 @@
+#include "a5_common.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+namespace duckdb {
+
+static constexpr const char *A5_DUCKDB_ALLOCATOR_SETTING = "a5_duckdb_allocator";
+
+// Allocation callbacks handed to the Rust library for one database, serving its blocks from the
+// database's buffer allocator so they count toward memory_limit. A thread uses the route of the database
+// whose scalar function it is running, so a database is only charged for its own queries. Every Rust
+// block remembers the route that served it, so routes are never freed: once the database is closed its
+// route stops serving new blocks and leaks the few that are returned late instead of touching the closed
+// buffer pool.
+struct A5AllocatorRoute {
+	explicit A5AllocatorRoute(Allocator &allocator) : allocator(allocator), enabled(false), active(true) {
+		callbacks.allocate = Allocate;
+		callbacks.free = Free;
+		callbacks.ctx = this;
+	}
+
+	// Past the memory limit the buffer allocator throws; returning null makes Rust fall back to the
+	// system allocator rather than abort the process, and the chunk then fails in A5RoutedFunction
+	static void *Allocate(void *ctx, uintptr_t size) {
+		auto &route = *static_cast<A5AllocatorRoute *>(ctx);
+		if (!route.active.load(std::memory_order_relaxed)) {
+			return nullptr;
+		}
+		try {
+			return route.allocator.AllocateData(size);
+		} catch (...) {
+			return nullptr;
+		}
+	}
+
+	static void Free(void *ctx, void *ptr, uintptr_t size) {
+		auto &route = *static_cast<A5AllocatorRoute *>(ctx);
+		if (route.active.load(std::memory_order_relaxed)) {
+			route.allocator.FreeData(static_cast<data_ptr_t>(ptr), size);
+		}
+	}
+
+	A5Allocator callbacks;
+	Allocator &allocator;
+	// Value of the a5_duckdb_allocator setting in the database
+	atomic<bool> enabled;
+	// False once the database is closed
+	atomic<bool> active;
+};
+
+// Number of open databases with a5_duckdb_allocator enabled. While it is zero the Rust library does not
+// look at the thread's route at all.
+static mutex a5_allocator_lock;
+static idx_t a5_routed_databases = 0;
+
+static void A5SetRouteEnabled(A5AllocatorRoute &route, bool enabled) {
+	lock_guard<mutex> guard(a5_allocator_lock);
+	if (route.enabled.load(std::memory_order_relaxed) == enabled) {
+		return;
+	}
+	route.enabled.store(enabled, std::memory_order_relaxed);
+	a5_routed_databases = enabled ? a5_routed_databases + 1 : a5_routed_databases - 1;
+	a5_set_allocator_routing(a5_routed_databases > 0);
+}
+
+// Owns a database's route through its object cache, which is destroyed with the database
+class A5AllocatorRouteEntry : public ObjectCacheEntry {
+public:
+	explicit A5AllocatorRouteEntry(Allocator &allocator) : route(new A5AllocatorRoute(allocator)) {
+	}
+
+	~A5AllocatorRouteEntry() override {
+		A5SetRouteEnabled(*route, false);
+		route->active.store(false, std::memory_order_relaxed);
+	}
+
+	static string ObjectType() {
+		return "a5_allocator_route";
+	}
+
+	string GetObjectType() override {
+		return ObjectType();
+	}
+
+	// Not a cache: the entry holds no memory of its own and must not be evicted
+	optional_idx GetEstimatedCacheMemory() const override {
+		return optional_idx();
+	}
+
+	A5AllocatorRoute *route;
+};
+
+static A5AllocatorRoute &A5GetAllocatorRoute(DatabaseInstance &db) {
+	return *db.GetObjectCache()
+	            .GetOrCreate<A5AllocatorRouteEntry>(A5AllocatorRouteEntry::ObjectType(), BufferAllocator::Get(db))
+	            ->route;
+}
+
+// Sets the thread's Rust allocator for the duration of a chunk and restores the previous one, also when
+// the function throws
+class A5ThreadAllocatorScope {
+public:
+	explicit A5ThreadAllocatorScope(const A5Allocator &allocator) : previous(a5_set_thread_allocator(&allocator)) {
+	}
+
+	~A5ThreadAllocatorScope() {
+		a5_set_thread_allocator(previous);
+	}
+
+private:
+	const A5Allocator *previous;
+};
+
+scalar_function_t A5RoutedFunction(DatabaseInstance &db, scalar_function_t function) {
+	auto route = &A5GetAllocatorRoute(db);
+	return [route, function](DataChunk &args, ExpressionState &state, Vector &result) {
+		if (!route->enabled.load(std::memory_order_relaxed)) {
+			function(args, state, result);
+			return;
+		}
+		a5_take_allocator_fallbacks();
+		{
+			A5ThreadAllocatorScope scope(route->callbacks);
+			function(args, state, result);
+		}
+		// Blocks the buffer allocator refused were taken from the system allocator so the Rust call could
+		// finish; the chunk still fails so that memory_limit holds
+		auto fallbacks = a5_take_allocator_fallbacks();
+		if (fallbacks > 0) {
+			throw OutOfMemoryException("a5: %llu allocations of the Rust library could not be served within "
+			                           "memory_limit (a5_duckdb_allocator is enabled)",
+			                           fallbacks);
+		}
+	};
+}
+
+static void A5SetDuckDBAllocator(ClientContext &context, SetScope scope, Value &parameter) {
+	A5SetRouteEnabled(A5GetAllocatorRoute(*context.db), !parameter.IsNull() && BooleanValue::Get(parameter));
+}
+
+void RegisterA5Allocator(ExtensionLoader &loader) {
+	auto &config = DBConfig::GetConfig(loader.GetDatabaseInstance());
+	config.AddExtensionOption(A5_DUCKDB_ALLOCATOR_SETTING,
+	                          "Serve the allocations the a5 scalar functions make in the Rust library from the "
+	                          "database's buffer allocator so they count toward memory_limit, instead of from the "
+	                          "system allocator, failing the query when they exceed it; applies to every connection of "
+	                          "the database",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false), A5SetDuckDBAllocator);
+}
+
+} // namespace duckdb
@@ -0,0 +1,56 @@
+#include "a5_common.hpp"
+#include "a5_hex.hpp"
+#include "duckdb/common/operator/cast_operators.hpp"
+#include "duckdb/function/cast/default_casts.hpp"
+#include "duckdb/function/cast/vector_cast_helpers.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+
+namespace duckdb {
+
+LogicalType A5CellType() {
+	auto type = LogicalType(LogicalTypeId::UBIGINT);
+	type.SetAlias("A5CELL");
+	return type;
+}
+
+static bool A5CellFromVarcharCast(Vector &source, Vector &result, idx_t count, CastParameters &parameters) {
+	bool all_converted = true;
+	UnaryExecutor::ExecuteWithNulls<string_t, uint64_t>(
+	    source, result, count, [&](string_t hex, ValidityMask &mask, idx_t idx) {
+		    uint64_t cell;
+		    if (!A5DecodeHex(hex.GetData(), hex.GetSize(), cell)) {
+			    HandleCastError::AssignError(
+			        StringUtil::Format("Could not convert string '%s' to A5CELL", hex.GetString()), parameters);
+			    mask.SetInvalid(idx);
+			    all_converted = false;
+			    return uint64_t(0);
+		    }
+		    return cell;
+	    });
+	return all_converted;
+}
+
+static bool A5CellToVarcharCast(Vector &source, Vector &result, idx_t count, CastParameters &parameters) {
+	UnaryExecutor::Execute<uint64_t, string_t>(source, result, count, [&](uint64_t cell) {
+		char buffer[A5_MAX_HEX_LENGTH];
+		auto length = A5EncodeHex(cell, buffer);
+		return StringVector::AddString(result, buffer, length);
+	});
+	return true;
+}
+
+void RegisterA5CellType(ExtensionLoader &loader) {
+	auto cell_type = A5CellType();
+	loader.RegisterType("A5CELL", cell_type);
+
+	// A5CELL shares the physical layout and ordering of UBIGINT, so casting between the two is a
+	// reinterpretation and comparisons, sorting and zone maps follow the Hilbert order of the index
+	loader.RegisterCastFunction(cell_type, LogicalType::UBIGINT, BoundCastInfo(DefaultCasts::ReinterpretCast), 0);
+	loader.RegisterCastFunction(LogicalType::UBIGINT, cell_type, BoundCastInfo(DefaultCasts::ReinterpretCast), 1);
+
+	// Hex text is the interchange format for cells
+	loader.RegisterCastFunction(LogicalType::VARCHAR, cell_type, BoundCastInfo(A5CellFromVarcharCast), 1);
+	loader.RegisterCastFunction(cell_type, LogicalType::VARCHAR, BoundCastInfo(A5CellToVarcharCast), 1);
+}
+
+} // namespace duckdb
@@ -0,0 +1,346 @@
+#include "a5_cell_set.hpp"
+#include "a5_common.hpp"
+#include "a5_function_table.hpp"
+#include "a5_index.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/common/unordered_map.hpp"
+#include "duckdb/common/unordered_set.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace duckdb {
+
+// Neighbouring cells compute their shared vertices independently, so the coordinates agree only up to
+// rounding. Vertices are matched on a grid far finer than the smallest cell (about 5 mm at resolution 30).
+static constexpr double A5_VERTEX_GRID = 1e-9;
+
+// Cells a mixed-resolution set may expand to before it is dissolved. Edges only cancel between cells of
+// one resolution, so every cell is split to the finest resolution in the set; past this the expansion
+// is refused rather than allocated.
+static constexpr uint64_t A5_MAX_DISSOLVE_CELLS = uint64_t(1) << 22;
+
+static constexpr uint32_t A5_NO_EDGE = NumericLimits<uint32_t>::Maximum();
+
+struct A5VertexKey {
+	int64_t lon;
+	int64_t lat;
+
+	bool operator==(const A5VertexKey &other) const {
+		return lon == other.lon && lat == other.lat;
+	}
+};
+
+struct A5VertexKeyHash {
+	size_t operator()(const A5VertexKey &key) const {
+		return CombineHash(Hash(key.lon), Hash(key.lat));
+	}
+};
+
+// A ring of the dissolved outline, closed (the first point is repeated at the end)
+struct A5OutlineRing {
+	vector<LonLatDegrees> points;
+	double area;
+	vector<idx_t> holes;
+};
+
+// Builds the outline of a set of cells at one resolution. Every cell contributes its edges as directed
+// segments between shared vertex ids; an edge between two cells of the set occurs once in each
+// direction and cancels, so what remains is exactly the outline, found in a single pass over the edges.
+class A5CellDissolver {
+public:
+	void Reset() {
+		vertex_ids.clear();
+		vertices.clear();
+		edges.clear();
+	}
+
+	void AddCell(const LonLatDegrees *ring, idx_t count) {
+		if (count < 3) {
+			return;
+		}
+		uint32_t first = VertexId(ring[0]);
+		uint32_t from = first;
+		for (idx_t i = 1; i <= count; i++) {
+			uint32_t to = i == count ? first : VertexId(ring[i]);
+			if (from != to) {
+				AddEdge(from, to);
+			}
+			from = to;
+		}
+		if (reference_orientation == 0) {
+			// All cells share the orientation of the first; outline rings with the opposite one are holes
+			reference_orientation = SignedArea(ring, count) >= 0 ? 1 : -1;
+		}
+	}
+
+	// Chains the remaining edges into rings and groups them into polygons
+	vector<A5OutlineRing> BuildRings() {
+		vector<uint64_t> remaining(edges.begin(), edges.end());
+		// Independent of the hash set's iteration order, so equal cell sets give identical blobs
+		std::sort(remaining.begin(), remaining.end());
+		vector<uint32_t> first_out(vertices.size(), A5_NO_EDGE);
+		vector<uint32_t> next_out(remaining.size(), A5_NO_EDGE);
+		for (uint32_t e = 0; e < remaining.size(); e++) {
+			auto from = EdgeFrom(remaining[e]);
+			next_out[e] = first_out[from];
+			first_out[from] = e;
+		}
+
+		vector<A5OutlineRing> rings;
+		vector<bool> used(remaining.size(), false);
+		for (uint32_t start_edge = 0; start_edge < remaining.size(); start_edge++) {
+			if (used[start_edge]) {
+				continue;
+			}
+			// Every vertex has as many outgoing as incoming edges, so the walk can only end at its start
+			A5OutlineRing ring;
+			auto start = EdgeFrom(remaining[start_edge]);
+			auto edge = start_edge;
+			while (true) {
+				used[edge] = true;
+				ring.points.push_back(vertices[EdgeFrom(remaining[edge])]);
+				auto to = EdgeTo(remaining[edge]);
+				if (to == start) {
+					break;
+				}
+				edge = NextUnused(first_out, next_out, used, to);
+				if (edge == A5_NO_EDGE) {
+					break;
+				}
+			}
+			if (ring.points.size() < 3) {
+				continue;
+			}
+			ring.area = SignedArea(ring.points.data(), ring.points.size()) * reference_orientation;
+			ring.points.push_back(ring.points[0]);
+			rings.push_back(std::move(ring));
+		}
+		return rings;
+	}
+
+	static double SignedArea(const LonLatDegrees *ring, idx_t count) {
+		double area = 0;
+		for (idx_t i = 0, j = count - 1; i < count; j = i++) {
+			area += (ring[j].lon - ring[i].lon) * (ring[j].lat + ring[i].lat);
+		}
+		return area / 2;
+	}
+
+private:
+	uint32_t VertexId(const LonLatDegrees &point) {
+		auto lon = static_cast<int64_t>(std::llround(point.lon / A5_VERTEX_GRID));
+		auto lat = static_cast<int64_t>(std::llround(point.lat / A5_VERTEX_GRID));
+		// A vertex rounded onto a neighbouring grid point still matches
+		for (int64_t d_lon = -1; d_lon <= 1; d_lon++) {
+			for (int64_t d_lat = -1; d_lat <= 1; d_lat++) {
+				auto entry = vertex_ids.find(A5VertexKey {lon + d_lon, lat + d_lat});
+				if (entry != vertex_ids.end()) {
+					return entry->second;
+				}
+			}
+		}
+		auto id = NumericCast<uint32_t>(vertices.size());
+		vertex_ids.emplace(A5VertexKey {lon, lat}, id);
+		vertices.push_back(point);
+		return id;
+	}
+
+	void AddEdge(uint32_t from, uint32_t to) {
+		auto reverse = edges.find(EdgeKey(to, from));
+		if (reverse != edges.end()) {
+			edges.erase(reverse);
+			return;
+		}
+		edges.insert(EdgeKey(from, to));
+	}
+
+	static uint32_t NextUnused(const vector<uint32_t> &first_out, const vector<uint32_t> &next_out,
+	                           const vector<bool> &used, uint32_t vertex) {
+		for (auto e = first_out[vertex]; e != A5_NO_EDGE; e = next_out[e]) {
+			if (!used[e]) {
+				return e;
+			}
+		}
+		return A5_NO_EDGE;
+	}
+
+	static uint64_t EdgeKey(uint32_t from, uint32_t to) {
+		return (uint64_t(from) << 32) | to;
+	}
+
+	static uint32_t EdgeFrom(uint64_t key) {
+		return static_cast<uint32_t>(key >> 32);
+	}
+
+	static uint32_t EdgeTo(uint64_t key) {
+		return static_cast<uint32_t>(key);
+	}
+
+	unordered_map<A5VertexKey, uint32_t, A5VertexKeyHash> vertex_ids;
+	vector<LonLatDegrees> vertices;
+	unordered_set<uint64_t> edges;
+	int32_t reference_orientation = 0;
+};
+
+static bool A5RingContains(const A5OutlineRing &ring, const LonLatDegrees &point) {
+	bool inside = false;
+	auto &points = ring.points;
+	for (idx_t i = 0, j = points.size() - 2; i + 1 < points.size(); j = i++) {
+		if ((points[i].lat > point.lat) != (points[j].lat > point.lat) &&
+		    point.lon < (points[j].lon - points[i].lon) * (point.lat - points[i].lat) / (points[j].lat - points[i].lat) +
+		                    points[i].lon) {
+			inside = !inside;
+		}
+	}
+	return inside;
+}
+
+// Assigns every hole to the smallest shell containing it and encodes the polygons as little-endian WKB
+static string_t A5WriteMultiPolygonWkb(Vector &result, vector<A5OutlineRing> &rings) {
+	vector<idx_t> shells;
+	for (idx_t i = 0; i < rings.size(); i++) {
+		if (rings[i].area > 0) {
+			shells.push_back(i);
+		}
+	}
+	for (idx_t i = 0; i < rings.size(); i++) {
+		if (rings[i].area > 0) {
+			continue;
+		}
+		optional_idx owner;
+		for (auto shell : shells) {
+			if (A5RingContains(rings[shell], rings[i].points[0]) &&
+			    (!owner.IsValid() || rings[shell].area < rings[owner.GetIndex()].area)) {
+				owner = shell;
+			}
+		}
+		if (owner.IsValid()) {
+			rings[owner.GetIndex()].holes.push_back(i);
+		} else {
+			// Not enclosed by any shell, which only happens for rings that are not planar in lon/lat
+			shells.push_back(i);
+		}
+	}
+
+	idx_t size = sizeof(uint8_t) + 2 * sizeof(uint32_t);
+	for (auto shell : shells) {
+		size += sizeof(uint8_t) + 3 * sizeof(uint32_t) + rings[shell].points.size() * sizeof(LonLatDegrees);
+		for (auto hole : rings[shell].holes) {
+			size += sizeof(uint32_t) + rings[hole].points.size() * sizeof(LonLatDegrees);
+		}
+	}
+	auto blob = StringVector::EmptyString(result, size);
+	auto ptr = data_ptr_cast(blob.GetDataWriteable());
+	auto write_ring = [&](const A5OutlineRing &ring) {
+		Store<uint32_t>(NumericCast<uint32_t>(ring.points.size()), ptr);
+		ptr += sizeof(uint32_t);
+		memcpy(ptr, ring.points.data(), ring.points.size() * sizeof(LonLatDegrees));
+		ptr += ring.points.size() * sizeof(LonLatDegrees);
+	};
+	*ptr++ = 1; // little-endian byte order
+	Store<uint32_t>(6, ptr); // wkbMultiPolygon
+	ptr += sizeof(uint32_t);
+	Store<uint32_t>(NumericCast<uint32_t>(shells.size()), ptr);
+	ptr += sizeof(uint32_t);
+	for (auto shell : shells) {
+		*ptr++ = 1;
+		Store<uint32_t>(3, ptr); // wkbPolygon
+		ptr += sizeof(uint32_t);
+		Store<uint32_t>(NumericCast<uint32_t>(1 + rings[shell].holes.size()), ptr);
+		ptr += sizeof(uint32_t);
+		write_ring(rings[shell]);
+		for (auto hole : rings[shell].holes) {
+			write_ring(rings[hole]);
+		}
+	}
+	blob.Finalize();
+	return blob;
+}
+
+// Brings a cell set to a single resolution, the finest one it contains
+static void A5NormalizeResolution(vector<uint64_t> &cells) {
+	A5RemoveCoveredCells(cells);
+	int32_t min_resolution = MAX_RESOLUTION;
+	int32_t max_resolution = 0;
+	for (auto cell : cells) {
+		int32_t resolution;
+		if (!a5_index::GetResolution(cell, resolution)) {
+			resolution = a5_get_resolution(cell);
+		}
+		min_resolution = MinValue(min_resolution, resolution);
+		max_resolution = MaxValue(max_resolution, resolution);
+	}
+	if (cells.empty() || min_resolution == max_resolution) {
+		return;
+	}
+	uint64_t expanded = 0;
+	for (auto cell : cells) {
+		int32_t resolution;
+		if (!a5_index::GetResolution(cell, resolution)) {
+			resolution = a5_get_resolution(cell);
+		}
+		expanded += a5_index::NumChildren(resolution, max_resolution);
+		if (expanded > A5_MAX_DISSOLVE_CELLS) {
+			throw InvalidInputException("a5_cells_to_multipolygon: cells of resolutions %d to %d expand to more than "
+			                            "%llu cells of resolution %d; pass the cells at fewer resolutions, for example "
+			                            "with a5_uncompact to a coarser resolution",
+			                            min_resolution, max_resolution, A5_MAX_DISSOLVE_CELLS, max_resolution);
+		}
+	}
+	vector<uint64_t> uncompacted;
+	ThrowRustError(a5_uncompact_into(cells.data(), cells.size(), max_resolution, A5VectorSink<uint64_t>, &uncompacted),
+	               "a5_cells_to_multipolygon");
+	cells = std::move(uncompacted);
+}
+
+static void A5CellsToMultiPolygonFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &list_vector = args.data[0];
+	auto &child_vector = ListVector::GetEntry(list_vector);
+	UnifiedVectorFormat child_format;
+	child_vector.ToUnifiedFormat(ListVector::GetListSize(list_vector), child_format);
+	auto child_data = UnifiedVectorFormat::GetData<uint64_t>(child_format);
+
+	A5CellDissolver dissolver;
+	vector<uint64_t> cells;
+	vector<LonLatDegrees> boundary;
+	UnaryExecutor::Execute<list_entry_t, string_t>(list_vector, result, args.size(), [&](list_entry_t entry) {
+		cells.clear();
+		for (idx_t i = entry.offset; i < entry.offset + entry.length; i++) {
+			auto idx = child_format.sel->get_index(i);
+			if (child_format.validity.RowIsValid(idx) && child_data[idx] != 0) {
+				cells.push_back(child_data[idx]);
+			}
+		}
+		A5NormalizeResolution(cells);
+
+		dissolver.Reset();
+		for (auto cell : cells) {
+			// Only the pentagon's corners: interpolated edge points are not shared between cells projected
+			// from different dodecahedron faces, so they would not cancel
+			CellBoundaryOptions options;
+			options.closed_ring = false;
+			options.segments = 1;
+			boundary.clear();
+			ThrowRustError(a5_cell_to_boundary_into(cell, options, A5VectorSink<LonLatDegrees>, &boundary),
+			               "a5_cells_to_multipolygon");
+			dissolver.AddCell(boundary.data(), boundary.size());
+		}
+		auto rings = dissolver.BuildRings();
+		return A5WriteMultiPolygonWkb(result, rings);
+	});
+}
+
+static const A5ScalarFunctionEntry A5_DISSOLVE_FUNCTIONS[] = {
+    {"a5_cells_to_multipolygon", {A5Type::CELL_LIST}, A5Type::BLOB, A5CellsToMultiPolygonFun,
+     "Returns the outline of a set of A5 cells as a WKB multipolygon, dissolving the edges shared by adjacent "
+     "cells; cells of mixed resolutions are expanded to the finest one",
+     {"cells"}, "ST_GeomFromWKB(a5_cells_to_multipolygon(a5_grid_disk(a5_lonlat_to_cell(-122.4, 37.8, 10), 2)))"},
+};
+
+void RegisterA5DissolveFunctions(ExtensionLoader &loader) {
+	A5RegisterScalarFunctions(loader, A5_DISSOLVE_FUNCTIONS);
+}
+
+} // namespace duckdb
@@ -4,127 +4,670 @@
 #include "duckdb.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/function/scalar_function.hpp"
+#include "duckdb/storage/statistics/numeric_stats.hpp"
 #include <duckdb/parser/parsed_data/create_scalar_function_info.hpp>
-#include "rust.h"
+#include "a5_arena.hpp"
+#include "a5_cell_set.hpp"
+#include "a5_common.hpp"
+#include "a5_function_table.hpp"
+#include "a5_grid_ring.hpp"
+#include "a5_hex.hpp"
+#include "a5_index.hpp"
+#include "a5_lookup_table.hpp"
+#include "a5_neighborhood_cache.hpp"
 #include "query_farm_telemetry.hpp"
+
+#include <mutex>
+
 namespace duckdb {
 
-#define MAX_RESOLUTION       30
-#define A5_EXTENSION_VERSION "2026031101"
+#define A5_EXTENSION_VERSION "2026101441"
 
-// Helper function to validate resolution and throw with a clear error message
-inline void ValidateResolution(int32_t resolution, const char *function_name) {
-	if (resolution < 0 || resolution > MAX_RESOLUTION) {
-		throw InvalidInputException(string(function_name) + ": Resolution must be between 0 and 30");
-	}
+// Location of the first element of a list result's child buffer, viewed as the element type
+// the Rust `*_into` entry points write.
+template <class T>
+T *A5ListChildData(Vector &list);
+
+template <>
+inline uint64_t *A5ListChildData(Vector &list) {
+	return FlatVector::GetData<uint64_t>(ListVector::GetEntry(list));
 }
 
-// Helper function to safely throw with error from Rust, freeing the error string
-inline void ThrowRustError(char *error_ptr, const char *function_name) {
-	if (error_ptr != nullptr) {
-		string error_msg = string(function_name) + ": " + string(error_ptr);
-		free(error_ptr);
-		throw InvalidInputException(error_msg);
-	}
+// ARRAY(DOUBLE, 2) keeps its values as one flat buffer of interleaved lon/lat pairs, which is
+// exactly the layout of LonLatDegrees
+static_assert(sizeof(LonLatDegrees) == 2 * sizeof(double), "LonLatDegrees must be two packed doubles");
+
+template <>
+inline LonLatDegrees *A5ListChildData(Vector &list) {
+	auto &array_vector = ListVector::GetEntry(list);
+	return reinterpret_cast<LonLatDegrees *>(FlatVector::GetData<double>(ArrayVector::GetEntry(array_vector)));
 }
 
-// Helper function to check CellArray for error, free it, and throw
-inline void ThrowCellArrayError(CellArray &arr, const char *function_name) {
-	if (arr.error) {
-		string error_msg = string(function_name) + ": " + string(arr.error);
-		a5_free_cell_array(arr);
-		throw InvalidInputException(error_msg);
+// Collects variable-length results from Rust directly into the child buffer of a list result
+// vector, so no per-element Value is built and no Rust allocation outlives the call.
+template <class T>
+class A5ListWriter {
+public:
+	explicit A5ListWriter(Vector &result) : result(result), size(ListVector::GetListSize(result)), pending(0) {
+	}
+
+	// Calls `fill(sink, ctx)`, which must invoke one of the Rust `*_into` entry points, and
+	// returns the list entry covering the elements it wrote.
+	template <class FUNC>
+	list_entry_t Write(FUNC &&fill, const char *function_name) {
+		pending = 0;
+		ThrowRustError(fill(&A5ListWriter::Reserve, static_cast<void *>(this)), function_name);
+		return Commit();
+	}
+
+	// Like Write, but returns false without appending anything when Rust rejects the input.
+	// Allocation failures still throw.
+	template <class FUNC>
+	bool TryWrite(FUNC &&fill, const char *function_name, list_entry_t &out) {
+		pending = 0;
+		auto error_code = fill(&A5ListWriter::Reserve, static_cast<void *>(this));
+		if (error_code == A5_ERROR) {
+			return false;
+		}
+		ThrowRustError(error_code, function_name);
+		out = Commit();
+		return true;
+	}
+
+	// The elements of an entry returned by this writer, valid until the next write
+	const T *Data(const list_entry_t &entry) const {
+		return A5ListChildData<T>(result) + entry.offset;
+	}
+
+	// Appends a copy of already computed elements
+	list_entry_t WriteValues(const vector<T> &values) {
+		ListVector::Reserve(result, size + values.size());
+		memcpy(A5ListChildData<T>(result) + size, values.data(), values.size() * sizeof(T));
+		list_entry_t out {size, values.size()};
+		size += values.size();
+		ListVector::SetListSize(result, size);
+		return out;
+	}
+
+private:
+	list_entry_t Commit() {
+		list_entry_t out {size, pending};
+		size += pending;
+		ListVector::SetListSize(result, size);
+		return out;
 	}
-}
 
-// Helper function to check LonLatDegreesArray for error, free it, and throw
-inline void ThrowLonLatArrayError(LonLatDegreesArray &arr, const char *function_name) {
-	if (arr.error) {
-		string error_msg = string(function_name) + ": " + string(arr.error);
-		a5_free_lonlatdegrees_array(arr);
-		throw InvalidInputException(error_msg);
+	static T *Reserve(void *ctx, uintptr_t len) {
+		auto &writer = *static_cast<A5ListWriter *>(ctx);
+		// Exceptions must not unwind through the Rust frames that called us
+		try {
+			ListVector::Reserve(writer.result, writer.size + len);
+		} catch (...) {
+			return nullptr;
+		}
+		writer.pending = len;
+		return A5ListChildData<T>(writer.result) + writer.size;
 	}
+
+	Vector &result;
+	idx_t size;
+	idx_t pending;
+};
+
+using A5CellListWriter = A5ListWriter<uint64_t>;
+using A5LonLatListWriter = A5ListWriter<LonLatDegrees>;
+
+// Encodes a single-ring polygon as little-endian WKB; an empty ring produces POLYGON EMPTY
+inline string_t A5WritePolygonWkb(Vector &result, const LonLatDegrees *ring, idx_t ring_size) {
+	idx_t size = sizeof(uint8_t) + 2 * sizeof(uint32_t);
+	if (ring_size > 0) {
+		size += sizeof(uint32_t) + ring_size * sizeof(LonLatDegrees);
+	}
+	auto blob = StringVector::EmptyString(result, size);
+	auto ptr = data_ptr_cast(blob.GetDataWriteable());
+	*ptr++ = 1; // little-endian byte order
+	Store<uint32_t>(3, ptr); // wkbPolygon
+	ptr += sizeof(uint32_t);
+	Store<uint32_t>(ring_size == 0 ? 0 : 1, ptr);
+	ptr += sizeof(uint32_t);
+	if (ring_size > 0) {
+		Store<uint32_t>(NumericCast<uint32_t>(ring_size), ptr);
+		ptr += sizeof(uint32_t);
+		memcpy(ptr, ring, ring_size * sizeof(LonLatDegrees));
+	}
+	blob.Finalize();
+	return blob;
 }
 
-inline void A5CellAreaFun(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto &resolution_vector = args.data[0];
-	UnaryExecutor::Execute<int32_t, double>(resolution_vector, result, args.size(), [&](int32_t resolution) {
-		ValidateResolution(resolution, "a5_cell_area");
-		return a5_cell_area(resolution);
-	});
+// Adapts a per-value operation into a scalar function implementation
+template <class INPUT_TYPE, class RESULT_TYPE, RESULT_TYPE (*OP)(INPUT_TYPE)>
+inline void A5UnaryFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	UnaryExecutor::Execute<INPUT_TYPE, RESULT_TYPE>(args.data[0], result, args.size(), OP);
 }
 
-inline void A5GetNumCellsFun(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto &resolution_vector = args.data[0];
-	UnaryExecutor::Execute<int32_t, uint64_t>(resolution_vector, result, args.size(), [&](int32_t resolution) {
-		ValidateResolution(resolution, "a5_get_num_cells");
-		return a5_get_num_cells(resolution);
-	});
+inline double A5CellArea(int32_t resolution) {
+	ValidateResolution(resolution, "a5_cell_area");
+	return a5_index::CELL_AREA[resolution];
 }
 
-inline void A5GetResolutionFun(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto &cell_vector = args.data[0];
-	UnaryExecutor::Execute<uint64_t, int32_t>(cell_vector, result, args.size(),
-	                                          [&](uint64_t cell) { return a5_get_resolution(cell); });
+inline uint64_t A5GetNumCells(int32_t resolution) {
+	ValidateResolution(resolution, "a5_get_num_cells");
+	return a5_index::NUM_CELLS[resolution];
+}
+
+// Number of 64-bit words needed for a one-bit-per-row mask over a full DataChunk
+#define A5_ROW_MASK_WORDS ((STANDARD_VECTOR_SIZE + 63) / 64)
+
+inline bool A5RowMaskIsSet(const uint64_t *mask, idx_t row) {
+	return (mask[row / 64] >> (row % 64)) & 1;
+}
+
+// Returns `count` contiguous values of a vector, copying through the selection vector into
+// `buffer` only when the vector is not already flat.
+template <class T>
+inline const T *A5ContiguousData(const UnifiedVectorFormat &format, idx_t count, T *buffer) {
+	auto data = UnifiedVectorFormat::GetData<T>(format);
+	if (!format.sel->IsSet()) {
+		return data;
+	}
+	for (idx_t i = 0; i < count; i++) {
+		buffer[i] = data[format.sel->get_index(i)];
+	}
+	return buffer;
 }
 
+// Builds a row mask with a bit set for every row where all of the given inputs are non-NULL.
+// Returns true if any row is NULL.
+inline bool A5BuildRowMask(const UnifiedVectorFormat *formats, idx_t format_count, idx_t count, uint64_t *mask) {
+	memset(mask, 0xFF, sizeof(uint64_t) * ((count + 63) / 64));
+	bool has_nulls = false;
+	for (idx_t f = 0; f < format_count; f++) {
+		auto &format = formats[f];
+		if (format.validity.AllValid()) {
+			continue;
+		}
+		for (idx_t i = 0; i < count; i++) {
+			if (!format.validity.RowIsValid(format.sel->get_index(i))) {
+				mask[i / 64] &= ~(uint64_t(1) << (i % 64));
+				has_nulls = true;
+			}
+		}
+	}
+	return has_nulls;
+}
+
+// TRY = true implements try_a5_lonlat_to_cell, which returns NULL for rows that fail to convert
+// instead of raising an error.
+template <bool TRY>
 inline void A5LonLatToCellFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto count = args.size();
 	auto &lon_vector = args.data[0];
 	auto &lat_vector = args.data[1];
 	auto &resolution_vector = args.data[2];
 
-	TernaryExecutor::Execute<double, double, int32_t, uint64_t>(
-	    lon_vector, lat_vector, resolution_vector, result, args.size(),
-	    [&](double lon, double lat, int32_t resolution) {
-		    ValidateResolution(resolution, "a5_lonlat_to_cell");
-		    struct ResultU64 res = a5_lon_lat_to_cell(lon, lat, resolution);
-		    ThrowRustError(res.error, "a5_lonlat_to_cell");
-		    return res.value;
-	    });
+	if (args.AllConstant()) {
+		result.SetVectorType(VectorType::CONSTANT_VECTOR);
+		if (ConstantVector::IsNull(lon_vector) || ConstantVector::IsNull(lat_vector) ||
+		    ConstantVector::IsNull(resolution_vector)) {
+			ConstantVector::SetNull(result, true);
+			return;
+		}
+		auto resolution = *ConstantVector::GetData<int32_t>(resolution_vector);
+		if (TRY && !IsValidResolution(resolution)) {
+			ConstantVector::SetNull(result, true);
+			return;
+		}
+		ValidateResolution(resolution, "a5_lonlat_to_cell");
+		struct ResultU64 res = a5_lon_lat_to_cell(*ConstantVector::GetData<double>(lon_vector),
+		                                          *ConstantVector::GetData<double>(lat_vector), resolution);
+		if (TRY && res.error_code != A5_OK) {
+			ConstantVector::SetNull(result, true);
+			return;
+		}
+		ThrowRustError(res.error_code, "a5_lonlat_to_cell");
+		*ConstantVector::GetData<uint64_t>(result) = res.value;
+		return;
+	}
+
+	UnifiedVectorFormat formats[3];
+	lon_vector.ToUnifiedFormat(count, formats[0]);
+	lat_vector.ToUnifiedFormat(count, formats[1]);
+	resolution_vector.ToUnifiedFormat(count, formats[2]);
+
+	uint64_t input_mask[A5_ROW_MASK_WORDS];
+	auto has_nulls = A5BuildRowMask(formats, 3, count, input_mask);
+
+	double lon_buffer[STANDARD_VECTOR_SIZE];
+	double lat_buffer[STANDARD_VECTOR_SIZE];
+	int32_t resolution_buffer[STANDARD_VECTOR_SIZE];
+	auto lon_data = A5ContiguousData<double>(formats[0], count, lon_buffer);
+	auto lat_data = A5ContiguousData<double>(formats[1], count, lat_buffer);
+
+	// A constant resolution is validated once and handed to Rust as a single value
+	bool constant_resolution = resolution_vector.GetVectorType() == VectorType::CONSTANT_VECTOR;
+	const int32_t *resolution_data;
+	if (constant_resolution) {
+		resolution_data = ConstantVector::GetData<int32_t>(resolution_vector);
+		if (!ConstantVector::IsNull(resolution_vector)) {
+			if (TRY && !IsValidResolution(*resolution_data)) {
+				result.SetVectorType(VectorType::CONSTANT_VECTOR);
+				ConstantVector::SetNull(result, true);
+				return;
+			}
+			ValidateResolution(*resolution_data, "a5_lonlat_to_cell");
+		}
+	} else {
+		resolution_data = A5ContiguousData<int32_t>(formats[2], count, resolution_buffer);
+		for (idx_t i = 0; i < count; i++) {
+			if (!A5RowMaskIsSet(input_mask, i)) {
+				continue;
+			}
+			if (TRY && !IsValidResolution(resolution_data[i])) {
+				input_mask[i / 64] &= ~(uint64_t(1) << (i % 64));
+				has_nulls = true;
+				continue;
+			}
+			ValidateResolution(resolution_data[i], "a5_lonlat_to_cell");
+		}
+	}
+
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto result_data = FlatVector::GetData<uint64_t>(result);
+	uint64_t output_mask[A5_ROW_MASK_WORDS];
+	memcpy(output_mask, input_mask, sizeof(output_mask));
+
+	auto failed = a5_lon_lat_to_cell_batch(lon_data, lat_data, resolution_data, constant_resolution, result_data,
+	                                       output_mask, count);
+	if (failed > 0) {
+		if (TRY) {
+			// The batch already cleared the bits of the failed rows; they become NULL below
+			has_nulls = true;
+		} else {
+			// Re-run the first failing row through the scalar entry point to obtain its error message
+			for (idx_t i = 0; i < count; i++) {
+				if (A5RowMaskIsSet(input_mask, i) && !A5RowMaskIsSet(output_mask, i)) {
+					auto resolution = constant_resolution ? resolution_data[0] : resolution_data[i];
+					struct ResultU64 res = a5_lon_lat_to_cell(lon_data[i], lat_data[i], resolution);
+					ThrowRustError(res.error_code, "a5_lonlat_to_cell");
+					break;
+				}
+			}
+			throw InvalidInputException("a5_lonlat_to_cell: failed to convert coordinate to cell");
+		}
+	}
+
+	if (has_nulls) {
+		auto &result_validity = FlatVector::Validity(result);
+		for (idx_t i = 0; i < count; i++) {
+			if (!A5RowMaskIsSet(output_mask, i)) {
+				result_validity.SetInvalid(i);
+			}
+		}
+	}
+}
+
+// Projects each point once at max_resolution and derives the coarser cells by truncating the index,
+// so a multi-resolution rollup costs a single lookup per row
+inline void A5LonLatToCellsFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto count = args.size();
+	UnifiedVectorFormat formats[4];
+	for (idx_t col = 0; col < 4; col++) {
+		args.data[col].ToUnifiedFormat(count, formats[col]);
+	}
+
+	uint64_t mask[A5_ROW_MASK_WORDS];
+	A5BuildRowMask(formats, 4, count, mask);
+
+	double lon_buffer[STANDARD_VECTOR_SIZE];
+	double lat_buffer[STANDARD_VECTOR_SIZE];
+	int32_t max_resolution_buffer[STANDARD_VECTOR_SIZE];
+	int32_t min_resolution_buffer[STANDARD_VECTOR_SIZE];
+	auto lon_data = A5ContiguousData<double>(formats[0], count, lon_buffer);
+	auto lat_data = A5ContiguousData<double>(formats[1], count, lat_buffer);
+	auto min_resolution_data = A5ContiguousData<int32_t>(formats[2], count, min_resolution_buffer);
+	auto max_resolution_data = A5ContiguousData<int32_t>(formats[3], count, max_resolution_buffer);
+
+	idx_t total_cells = 0;
+	for (idx_t i = 0; i < count; i++) {
+		if (!A5RowMaskIsSet(mask, i)) {
+			continue;
+		}
+		ValidateResolution(min_resolution_data[i], "a5_lonlat_to_cells");
+		ValidateResolution(max_resolution_data[i], "a5_lonlat_to_cells");
+		if (min_resolution_data[i] > max_resolution_data[i]) {
+			throw InvalidInputException("a5_lonlat_to_cells: min_resolution (%d) must not exceed max_resolution (%d)",
+			                            min_resolution_data[i], max_resolution_data[i]);
+		}
+		total_cells += max_resolution_data[i] - min_resolution_data[i] + 1;
+	}
+
+	uint64_t cells[STANDARD_VECTOR_SIZE];
+	uint64_t output_mask[A5_ROW_MASK_WORDS];
+	memcpy(output_mask, mask, sizeof(output_mask));
+	auto failed =
+	    a5_lon_lat_to_cell_batch(lon_data, lat_data, max_resolution_data, false, cells, output_mask, count);
+	if (failed > 0) {
+		for (idx_t i = 0; i < count; i++) {
+			if (A5RowMaskIsSet(mask, i) && !A5RowMaskIsSet(output_mask, i)) {
+				struct ResultU64 res = a5_lon_lat_to_cell(lon_data[i], lat_data[i], max_resolution_data[i]);
+				ThrowRustError(res.error_code, "a5_lonlat_to_cells");
+				break;
+			}
+		}
+		throw InvalidInputException("a5_lonlat_to_cells: failed to convert coordinate to cell");
+	}
+
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto list_entries = FlatVector::GetData<list_entry_t>(result);
+	auto &validity = FlatVector::Validity(result);
+	auto offset = ListVector::GetListSize(result);
+	ListVector::Reserve(result, offset + total_cells);
+	auto child_data = A5ListChildData<uint64_t>(result);
+	for (idx_t i = 0; i < count; i++) {
+		if (!A5RowMaskIsSet(mask, i)) {
+			validity.SetInvalid(i);
+			continue;
+		}
+		auto min_resolution = min_resolution_data[i];
+		auto max_resolution = max_resolution_data[i];
+		list_entries[i] = {offset, idx_t(max_resolution - min_resolution + 1)};
+		for (int32_t resolution = min_resolution; resolution <= max_resolution; resolution++) {
+			uint64_t parent;
+			if (!a5_index::CellToParent(cells[i], resolution, parent)) {
+				struct ResultU64 res = a5_cell_to_parent(cells[i], resolution);
+				ThrowRustError(res.error_code, "a5_lonlat_to_cells");
+				parent = res.value;
+			}
+			child_data[offset++] = parent;
+		}
+	}
+	ListVector::SetListSize(result, offset);
 }
 
+// A constant cell set of a5_cells_contain_point, sorted into disjoint ranges once per chunk. A point lies
+// in the set exactly when its cell at the finest resolution of the set falls into one of the ranges.
+struct A5PointInCellSet {
+	vector<A5CellRange> ranges;
+	int32_t resolution = 0;
+
+	void Build(const uint64_t *cells, idx_t count) {
+		A5DisjointRanges(cells, count, ranges);
+		resolution = 0;
+		for (auto &range : ranges) {
+			resolution = MaxValue(resolution, A5GetResolution(range.cell));
+		}
+	}
+
+	bool Contains(uint64_t point_cell) const {
+		auto target = A5CellRange::FromCell(point_cell);
+		// Only the last range starting at or before the point's cell can contain it
+		auto it = std::upper_bound(ranges.begin(), ranges.end(), target.lo,
+		                           [](uint64_t lo, const A5CellRange &range) { return lo < range.lo; });
+		return it != ranges.begin() && target.hi <= (it - 1)->hi;
+	}
+};
+
+// a5_cell_contains_point and a5_cells_contain_point. Each point is projected once, at the resolution of
+// the cell or the finest resolution in the list rather than at resolution 30, in one batch per chunk;
+// containment is then decided on index ranges.
+template <bool LIST>
+inline void A5ContainsPointFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto function_name = LIST ? "a5_cells_contain_point" : "a5_cell_contains_point";
+	auto count = args.size();
+	auto &cells_vector = args.data[0];
+	UnifiedVectorFormat formats[3];
+	for (idx_t col = 0; col < 3; col++) {
+		args.data[col].ToUnifiedFormat(count, formats[col]);
+	}
+
+	uint64_t mask[A5_ROW_MASK_WORDS];
+	A5BuildRowMask(formats, 3, count, mask);
+
+	double lon_buffer[STANDARD_VECTOR_SIZE];
+	double lat_buffer[STANDARD_VECTOR_SIZE];
+	auto lon_data = A5ContiguousData<double>(formats[1], count, lon_buffer);
+	auto lat_data = A5ContiguousData<double>(formats[2], count, lat_buffer);
+
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto result_data = FlatVector::GetData<bool>(result);
+	auto &result_validity = FlatVector::Validity(result);
+
+	// Rows that need a projection; NULL rows and empty lists do not
+	uint64_t project_mask[A5_ROW_MASK_WORDS];
+	memcpy(project_mask, mask, sizeof(project_mask));
+	for (idx_t i = 0; i < count; i++) {
+		result_data[i] = false;
+		if (!A5RowMaskIsSet(mask, i)) {
+			result_validity.SetInvalid(i);
+		}
+	}
+
+	auto cell_data = UnifiedVectorFormat::GetData<uint64_t>(formats[0]);
+	auto list_data = UnifiedVectorFormat::GetData<list_entry_t>(formats[0]);
+	// NULL entries of a list contain nothing and are skipped
+	UnifiedVectorFormat child_format;
+	if (LIST) {
+		ListVector::GetEntry(cells_vector).ToUnifiedFormat(ListVector::GetListSize(cells_vector), child_format);
+	}
+	auto child_data = LIST ? UnifiedVectorFormat::GetData<uint64_t>(child_format) : nullptr;
+	vector<uint64_t> row_cells;
+	auto gather_row_cells = [&](const list_entry_t &entry) {
+		row_cells.clear();
+		for (idx_t c = entry.offset; c < entry.offset + entry.length; c++) {
+			auto child_idx = child_format.sel->get_index(c);
+			if (child_format.validity.RowIsValid(child_idx)) {
+				row_cells.push_back(child_data[child_idx]);
+			}
+		}
+	};
+
+	// A constant cell or list is resolved once and gives every row the same projection resolution
+	bool constant_cells = cells_vector.GetVectorType() == VectorType::CONSTANT_VECTOR;
+	A5PointInCellSet cell_set;
+	int32_t resolution_buffer[STANDARD_VECTOR_SIZE];
+	if (constant_cells) {
+		if (ConstantVector::IsNull(cells_vector)) {
+			return;
+		}
+		if (LIST) {
+			gather_row_cells(list_data[formats[0].sel->get_index(0)]);
+			if (row_cells.empty()) {
+				// Contains nothing, so every row is false without a projection
+				return;
+			}
+			cell_set.Build(row_cells.data(), row_cells.size());
+			resolution_buffer[0] = cell_set.resolution;
+		} else {
+			resolution_buffer[0] = A5GetResolution(cell_data[0]);
+		}
+		ValidateResolution(resolution_buffer[0], function_name);
+	} else {
+		for (idx_t i = 0; i < count; i++) {
+			if (!A5RowMaskIsSet(project_mask, i)) {
+				continue;
+			}
+			auto cells_idx = formats[0].sel->get_index(i);
+			int32_t resolution = 0;
+			if (LIST) {
+				gather_row_cells(list_data[cells_idx]);
+				if (row_cells.empty()) {
+					project_mask[i / 64] &= ~(uint64_t(1) << (i % 64));
+					continue;
+				}
+				for (auto cell : row_cells) {
+					resolution = MaxValue(resolution, A5GetResolution(cell));
+				}
+			} else {
+				resolution = A5GetResolution(cell_data[cells_idx]);
+			}
+			ValidateResolution(resolution, function_name);
+			resolution_buffer[i] = resolution;
+		}
+	}
+
+	uint64_t point_cells[STANDARD_VECTOR_SIZE];
+	uint64_t output_mask[A5_ROW_MASK_WORDS];
+	memcpy(output_mask, project_mask, sizeof(output_mask));
+	auto failed = a5_lon_lat_to_cell_batch(lon_data, lat_data, resolution_buffer, constant_cells, point_cells,
+	                                       output_mask, count);
+	if (failed > 0) {
+		for (idx_t i = 0; i < count; i++) {
+			if (A5RowMaskIsSet(project_mask, i) && !A5RowMaskIsSet(output_mask, i)) {
+				auto resolution = constant_cells ? resolution_buffer[0] : resolution_buffer[i];
+				struct ResultU64 res = a5_lon_lat_to_cell(lon_data[i], lat_data[i], resolution);
+				ThrowRustError(res.error_code, function_name);
+				break;
+			}
+		}
+		throw InvalidInputException("%s: failed to convert coordinate to cell", function_name);
+	}
+
+	for (idx_t i = 0; i < count; i++) {
+		if (!A5RowMaskIsSet(project_mask, i)) {
+			continue;
+		}
+		auto cells_idx = formats[0].sel->get_index(i);
+		if (!LIST) {
+			result_data[i] = point_cells[i] == cell_data[cells_idx];
+		} else if (constant_cells) {
+			result_data[i] = cell_set.Contains(point_cells[i]);
+		} else {
+			// One point per list: a scan is cheaper than sorting the list into ranges to search them
+			gather_row_cells(list_data[cells_idx]);
+			auto target = A5CellRange::FromCell(point_cells[i]);
+			for (idx_t c = 0; c < row_cells.size() && !result_data[i]; c++) {
+				auto range = A5CellRange::FromCell(row_cells[c]);
+				result_data[i] = range.lo <= target.lo && target.hi <= range.hi;
+			}
+		}
+	}
+}
+
+template <bool TRY>
 inline void A5CellToParentFun(DataChunk &args, ExpressionState &state, Vector &result) {
 	auto &cell_vector = args.data[0];
 	auto &parent_resolution_vector = args.data[1];
 
-	BinaryExecutor::Execute<uint64_t, int32_t, uint64_t>(
-	    cell_vector, parent_resolution_vector, result, args.size(), [&](uint64_t cell, int32_t parent_resolution) {
+	BinaryExecutor::ExecuteWithNulls<uint64_t, int32_t, uint64_t>(
+	    cell_vector, parent_resolution_vector, result, args.size(),
+	    [&](uint64_t cell, int32_t parent_resolution, ValidityMask &mask, idx_t idx) {
+		    if (TRY && !IsValidResolution(parent_resolution)) {
+			    mask.SetInvalid(idx);
+			    return uint64_t(0);
+		    }
 		    ValidateResolution(parent_resolution, "a5_cell_to_parent");
+		    uint64_t parent;
+		    if (a5_index::CellToParent(cell, parent_resolution, parent)) {
+			    return parent;
+		    }
+		    int32_t resolution;
+		    if (a5_index::GetResolution(cell, resolution) && parent_resolution > resolution) {
+			    if (TRY) {
+				    mask.SetInvalid(idx);
+				    return uint64_t(0);
+			    }
+			    throw InvalidInputException(
+			        "a5_cell_to_parent: parent resolution %d is finer than the cell's resolution %d",
+			        parent_resolution, resolution);
+		    }
 		    struct ResultU64 res = a5_cell_to_parent(cell, parent_resolution);
-		    ThrowRustError(res.error, "a5_cell_to_parent");
+		    if (TRY && res.error_code != A5_OK) {
+			    mask.SetInvalid(idx);
+			    return uint64_t(0);
+		    }
+		    ThrowRustError(res.error_code, "a5_cell_to_parent");
 		    return res.value;
 	    });
 }
 
-inline void A5CellToLonLatFun(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto &cell_vector = args.data[0];
-
-	auto &result_data_children = ArrayVector::GetEntry(result);
-	double *data_ptr = FlatVector::GetData<double>(result_data_children);
-
-	// Standardize the vectors to a unified format, so it can be iterated.
-	UnifiedVectorFormat cell_id_format;
-	cell_vector.ToUnifiedFormat(args.size(), cell_id_format);
+// Rust entry point converting a batch of cells into interleaved pairs of doubles
+typedef uintptr_t (*a5_cell_to_pair_batch_t)(const uint64_t *cells, double *out, uint64_t *validity, uintptr_t len);
+
+// Converts cells into the DOUBLE[2] result with one FFI call per chunk, writing straight into the
+// array's child buffer. SCALAR is only called to obtain the error message of a failed row.
+template <bool TRY, class RESULT, RESULT (*SCALAR)(uint64_t), a5_cell_to_pair_batch_t BATCH>
+void A5CellToPairExecute(Vector &cell_vector, idx_t count, Vector &result, const char *function_name) {
+	UnifiedVectorFormat format;
+	cell_vector.ToUnifiedFormat(count, format);
+	uint64_t input_mask[A5_ROW_MASK_WORDS];
+	auto has_nulls = A5BuildRowMask(&format, 1, count, input_mask);
+	uint64_t cell_buffer[STANDARD_VECTOR_SIZE];
+	auto cells = A5ContiguousData<uint64_t>(format, count, cell_buffer);
+
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto out = FlatVector::GetData<double>(ArrayVector::GetEntry(result));
+	uint64_t output_mask[A5_ROW_MASK_WORDS];
+	memcpy(output_mask, input_mask, sizeof(output_mask));
+	auto failed = BATCH(cells, out, output_mask, count);
+	if (failed > 0) {
+		if (!TRY) {
+			for (idx_t i = 0; i < count; i++) {
+				if (A5RowMaskIsSet(input_mask, i) && !A5RowMaskIsSet(output_mask, i)) {
+					ThrowRustError(SCALAR(cells[i]).error_code, function_name);
+					break;
+				}
+			}
+			throw InvalidInputException("%s: failed to convert cell", function_name);
+		}
+		has_nulls = true;
+	}
 
-	uint64_t *input_data_ptr = FlatVector::GetData<uint64_t>(cell_vector);
+	if (has_nulls) {
+		auto &validity = FlatVector::Validity(result);
+		for (idx_t i = 0; i < count; i++) {
+			if (!A5RowMaskIsSet(output_mask, i)) {
+				validity.SetInvalid(i);
+			}
+		}
+	}
+}
 
-	for (idx_t i = 0; i < args.size(); i++) {
-		auto cell_idx = cell_id_format.sel->get_index(i);
+template <bool TRY>
+inline void A5CellToLonLatFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	A5CellToPairExecute<TRY, ResultLonLat, a5_cell_to_lon_lat, A5CellToLonLatBatch>(
+	    args.data[0], args.size(), result, "a5_cell_to_lonlat");
+}
 
-		// If the input value is NULL then the output value should be NULL.
-		if (!cell_id_format.validity.RowIsValid(cell_idx)) {
+inline void A5CellToRangeFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto count = args.size();
+	UnifiedVectorFormat cell_format, resolution_format;
+	args.data[0].ToUnifiedFormat(count, cell_format);
+	args.data[1].ToUnifiedFormat(count, resolution_format);
+	auto cells = UnifiedVectorFormat::GetData<uint64_t>(cell_format);
+	auto resolutions = UnifiedVectorFormat::GetData<int32_t>(resolution_format);
+
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto range_data = FlatVector::GetData<uint64_t>(ArrayVector::GetEntry(result));
+
+	for (idx_t i = 0; i < count; i++) {
+		auto cell_idx = cell_format.sel->get_index(i);
+		auto resolution_idx = resolution_format.sel->get_index(i);
+		if (!cell_format.validity.RowIsValid(cell_idx) || !resolution_format.validity.RowIsValid(resolution_idx)) {
 			FlatVector::SetNull(result, i, true);
 			continue;
 		}
-
-		struct ResultLonLat res = a5_cell_to_lon_lat(input_data_ptr[cell_idx]);
-		ThrowRustError(res.error, "a5_cell_to_lonlat");
-
-		data_ptr[i * 2] = res.longitude;
-		data_ptr[i * 2 + 1] = res.latitude;
+		auto cell = cells[cell_idx];
+		auto target_resolution = resolutions[resolution_idx];
+		ValidateResolution(target_resolution, "a5_cell_to_range");
+		auto &lo = range_data[i * 2];
+		auto &hi = range_data[i * 2 + 1];
+		if (a5_index::CellToDescendantRange(cell, target_resolution, lo, hi)) {
+			continue;
+		}
+		auto resolution = a5_get_resolution(cell);
+		if (resolution == MAX_RESOLUTION && target_resolution == MAX_RESOLUTION) {
+			lo = hi = cell;
+			continue;
+		}
+		bool valid;
+		if (resolution < 0 || (a5_index::IsValidCell(cell, valid) && !valid)) {
+			throw InvalidInputException("a5_cell_to_range: %llu is not a valid A5 cell", cell);
+		}
+		throw InvalidInputException("a5_cell_to_range: target resolution %d is coarser than the cell's resolution %d",
+		                            target_resolution, resolution);
 	}
 
-	if (args.size() == 1) {
+	if (args.AllConstant()) {
 		result.SetVectorType(VectorType::CONSTANT_VECTOR);
 	}
 }
@@ -132,7 +675,7 @@ inline void A5CellToLonLatFun(DataChunk &args, ExpressionState &state, Vector &r
 inline void A5CellToChildrenFun(DataChunk &args, ExpressionState &state, Vector &result) {
 	// A5 cells have exactly 4 children
 	ListVector::Reserve(result, args.size() * 4);
-	uint64_t offset = 0;
+	A5CellListWriter writer(result);
 
 	if (args.ColumnCount() == 2) {
 		auto &cell_vector = args.data[0];
@@ -141,52 +684,34 @@ inline void A5CellToChildrenFun(DataChunk &args, ExpressionState &state, Vector
 		BinaryExecutor::Execute<uint64_t, int32_t, list_entry_t>(
 		    cell_vector, max_resolution_vector, result, args.size(), [&](uint64_t cell_id, int32_t child_resolution) {
 			    ValidateResolution(child_resolution, "a5_cell_to_children");
-			    auto child_result = a5_cell_to_children(cell_id, child_resolution);
-			    ThrowCellArrayError(child_result, "a5_cell_to_children");
-
-			    if (child_result.len == 0) {
-				    a5_free_cell_array(child_result);
-				    return list_entry_t {0, 0};
-			    }
-			    for (size_t i = 0; i < child_result.len; i++) {
-				    ListVector::PushBack(result, Value::UBIGINT(child_result.data[i]));
-			    }
-			    list_entry_t out {offset, child_result.len};
-			    offset += child_result.len;
-			    a5_free_cell_array(child_result);
-			    return out;
+			    return writer.Write(
+			        [&](CellSink sink, void *ctx) {
+				        return a5_cell_to_children_into(cell_id, child_resolution, sink, ctx);
+			        },
+			        "a5_cell_to_children");
 		    });
 	} else if (args.ColumnCount() == 1) {
 		auto &cell_vector = args.data[0];
 
 		UnaryExecutor::Execute<uint64_t, list_entry_t>(cell_vector, result, args.size(), [&](uint64_t cell_id) {
-			auto child_result = a5_cell_to_children(cell_id, -1);
-			ThrowCellArrayError(child_result, "a5_cell_to_children");
-
-			if (child_result.len == 0) {
-				a5_free_cell_array(child_result);
-				return list_entry_t {0, 0};
-			}
-			for (size_t i = 0; i < child_result.len; i++) {
-				ListVector::PushBack(result, Value::UBIGINT(child_result.data[i]));
-			}
-			list_entry_t out {offset, child_result.len};
-			offset += child_result.len;
-			a5_free_cell_array(child_result);
-			return out;
+			return writer.Write(
+			    [&](CellSink sink, void *ctx) { return a5_cell_to_children_into(cell_id, -1, sink, ctx); },
+			    "a5_cell_to_children");
 		});
 	} else {
 		throw InvalidInputException("A5CellToChildrenFun: expected 1 or 2 arguments.");
 	}
 }
 
+template <bool TRY>
 inline void A5CellToBoundaryFun(DataChunk &args, ExpressionState &state, Vector &result) {
 	auto &cell_vector = args.data[0];
 	// A5 cells are pentagons with 5 vertices
 	ListVector::Reserve(result, args.size() * 5);
-	uint64_t offset = 0;
+	A5LonLatListWriter writer(result);
 
-	auto compute_boundary = [&](uint64_t cell_id, bool closed_ring, int32_t segments) -> list_entry_t {
+	auto compute_boundary = [&](uint64_t cell_id, bool closed_ring, int32_t segments, ValidityMask &mask,
+	                            idx_t idx) -> list_entry_t {
 		if (cell_id == 0) {
 			// A5 defines cell 0 as invalid / non-existent, so return an empty boundary
 			return {0, 0};
@@ -196,60 +721,91 @@ inline void A5CellToBoundaryFun(DataChunk &args, ExpressionState &state, Vector
 		options.closed_ring = closed_ring;
 		options.segments = segments;
 
-		auto boundary_result = a5_cell_to_boundary(cell_id, options);
-		ThrowLonLatArrayError(boundary_result, "a5_cell_to_boundary");
-		if (boundary_result.len == 0) {
-			a5_free_lonlatdegrees_array(boundary_result);
-			return {0, 0};
+		auto fill = [&](LonLatSink sink, void *ctx) { return A5CellToBoundaryInto(cell_id, options, sink, ctx); };
+		if (!TRY) {
+			return writer.Write(fill, "a5_cell_to_boundary");
 		}
-
-		for (size_t i = 0; i < boundary_result.len; i++) {
-			auto &coord = boundary_result.data[i];
-			ListVector::PushBack(
-			    result, Value::ARRAY(LogicalType::DOUBLE, {Value::DOUBLE(coord.lon), Value::DOUBLE(coord.lat)}));
+		list_entry_t entry {0, 0};
+		if (!writer.TryWrite(fill, "a5_cell_to_boundary", entry)) {
+			mask.SetInvalid(idx);
 		}
-
-		list_entry_t out {offset, boundary_result.len};
-		offset += boundary_result.len;
-		a5_free_lonlatdegrees_array(boundary_result);
-		return out;
+		return entry;
 	};
 
 	if (args.ColumnCount() == 1) {
-		UnaryExecutor::Execute<uint64_t, list_entry_t>(
-		    cell_vector, result, args.size(), [&](uint64_t cell_id) { return compute_boundary(cell_id, true, -1); });
+		UnaryExecutor::ExecuteWithNulls<uint64_t, list_entry_t>(
+		    cell_vector, result, args.size(), [&](uint64_t cell_id, ValidityMask &mask, idx_t idx) {
+			    return compute_boundary(cell_id, true, -1, mask, idx);
+		    });
 	} else if (args.ColumnCount() == 2) {
 		auto &closed_ring_vector = args.data[1];
-		BinaryExecutor::Execute<uint64_t, bool, list_entry_t>(
+		BinaryExecutor::ExecuteWithNulls<uint64_t, bool, list_entry_t>(
 		    cell_vector, closed_ring_vector, result, args.size(),
-		    [&](uint64_t cell_id, bool closed_ring) { return compute_boundary(cell_id, closed_ring, -1); });
+		    [&](uint64_t cell_id, bool closed_ring, ValidityMask &mask, idx_t idx) {
+			    return compute_boundary(cell_id, closed_ring, -1, mask, idx);
+		    });
 	} else if (args.ColumnCount() == 3) {
 		auto &closed_ring_vector = args.data[1];
 		auto &segments_vector = args.data[2];
-		TernaryExecutor::Execute<uint64_t, bool, int32_t, list_entry_t>(
+		TernaryExecutor::ExecuteWithNulls<uint64_t, bool, int32_t, list_entry_t>(
 		    cell_vector, closed_ring_vector, segments_vector, result, args.size(),
-		    [&](uint64_t cell_id, bool closed_ring, int32_t segments) {
+		    [&](uint64_t cell_id, bool closed_ring, int32_t segments, ValidityMask &mask, idx_t idx) {
 			    if (segments <= 0) {
 				    segments = -1;
 			    }
-			    return compute_boundary(cell_id, closed_ring, segments);
+			    return compute_boundary(cell_id, closed_ring, segments, mask, idx);
 		    });
 	} else {
 		throw InvalidInputException("A5CellToBoundaryFun: expected 1, 2 or 3 arguments.");
 	}
 }
 
-inline void A5GetRes0CellsFun(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto cells = a5_get_res0_cells();
-	vector<Value> cell_vec;
-	for (size_t i = 0; i < cells.len; i++) {
-		cell_vec.emplace_back(Value::UBIGINT(cells.data[i]));
+inline void A5CellToBoundaryWkbFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &cell_vector = args.data[0];
+	// The boundary is staged in the chunk arena before it is encoded into the blob
+	A5ArenaBuffer<LonLatDegrees> ring(A5ChunkArena(state));
+
+	auto compute_wkb = [&](uint64_t cell_id, int32_t segments) -> string_t {
+		ring.Clear();
+		if (cell_id != 0) {
+			CellBoundaryOptions options;
+			options.closed_ring = true;
+			options.segments = segments;
+			ThrowRustError(A5CellToBoundaryInto(cell_id, options, A5ArenaSink<LonLatDegrees>, &ring),
+			               "a5_cell_to_boundary_wkb");
+		}
+		return A5WritePolygonWkb(result, ring.begin(), ring.size());
+	};
+
+	if (args.ColumnCount() == 1) {
+		UnaryExecutor::Execute<uint64_t, string_t>(cell_vector, result, args.size(),
+		                                           [&](uint64_t cell_id) { return compute_wkb(cell_id, -1); });
+	} else if (args.ColumnCount() == 2) {
+		auto &segments_vector = args.data[1];
+		BinaryExecutor::Execute<uint64_t, int32_t, string_t>(cell_vector, segments_vector, result, args.size(),
+		                                                     [&](uint64_t cell_id, int32_t segments) {
+			                                                     return compute_wkb(cell_id, segments <= 0 ? -1 : segments);
+		                                                     });
+	} else {
+		throw InvalidInputException("A5CellToBoundaryWkbFun: expected 1 or 2 arguments.");
 	}
-	a5_free_cell_array(cells);
-	Value val = Value::LIST(LogicalType::UBIGINT, cell_vec);
+}
 
+// The list value is built once per process as well
+static const Value &A5Res0CellsValue() {
+	static const Value res0_cells = [] {
+		vector<Value> cell_vec;
+		for (auto cell : A5Res0Cells()) {
+			cell_vec.emplace_back(Value::UBIGINT(cell));
+		}
+		return Value::LIST(LogicalType::UBIGINT, std::move(cell_vec));
+	}();
+	return res0_cells;
+}
+
+inline void A5GetRes0CellsFun(DataChunk &args, ExpressionState &state, Vector &result) {
 	D_ASSERT(args.ColumnCount() == 0);
-	result.Reference(val);
+	result.Reference(A5Res0CellsValue());
 }
 
 inline void A5CompactFun(DataChunk &args, ExpressionState &state, Vector &result) {
@@ -257,31 +813,17 @@ inline void A5CompactFun(DataChunk &args, ExpressionState &state, Vector &result
 
 	// Initial estimate; compacted output is typically smaller than input
 	ListVector::Reserve(result, args.size() * 4);
-	uint64_t offset = 0;
+	A5CellListWriter writer(result);
 
 	auto cell_list_data = FlatVector::GetData<uint64_t>(ListVector::GetEntry(cell_list_vector));
 
-	auto result_size = ListVector::GetListSize(result);
-
 	UnaryExecutor::Execute<list_entry_t, list_entry_t>(
 	    cell_list_vector, result, args.size(), [&](list_entry_t cell_list_entry) {
-		    // We need to prepare the list of values to pass in.
-		    auto compact_result = a5_compact(cell_list_data + cell_list_entry.offset, cell_list_entry.length);
-		    ThrowCellArrayError(compact_result, "a5_compact");
-		    if (compact_result.len == 0) {
-			    a5_free_cell_array(compact_result);
-			    return list_entry_t {0, 0};
-		    }
-		    ListVector::Reserve(result, result_size + compact_result.len);
-		    for (size_t i = 0; i < compact_result.len; i++) {
-			    ListVector::PushBack(result, Value::UBIGINT(compact_result.data[i]));
-		    }
-		    result_size += compact_result.len;
-
-		    list_entry_t out {offset, compact_result.len};
-		    offset += compact_result.len;
-		    a5_free_cell_array(compact_result);
-		    return out;
+		    return writer.Write(
+		        [&](CellSink sink, void *ctx) {
+			        return a5_compact_into(cell_list_data + cell_list_entry.offset, cell_list_entry.length, sink, ctx);
+		        },
+		        "a5_compact");
 	    });
 }
 
@@ -291,68 +833,107 @@ inline void A5UncompactFun(DataChunk &args, ExpressionState &state, Vector &resu
 
 	// Initial estimate; each cell expands to 4 children per resolution level
 	ListVector::Reserve(result, args.size() * 4);
-	uint64_t offset = 0;
+	A5CellListWriter writer(result);
 
 	auto cell_list_data = FlatVector::GetData<uint64_t>(ListVector::GetEntry(cell_list_vector));
 
-	auto result_size = ListVector::GetListSize(result);
-
 	BinaryExecutor::Execute<list_entry_t, int32_t, list_entry_t>(
 	    cell_list_vector, target_resolution_vector, result, args.size(),
 	    [&](list_entry_t cell_list_entry, int32_t target_resolution) {
 		    ValidateResolution(target_resolution, "a5_uncompact");
-		    // We need to prepare the list of values to pass in.
-		    auto compact_result =
-		        a5_uncompact(cell_list_data + cell_list_entry.offset, cell_list_entry.length, target_resolution);
-		    ThrowCellArrayError(compact_result, "a5_uncompact");
-		    if (compact_result.len == 0) {
-			    a5_free_cell_array(compact_result);
-			    return list_entry_t {0, 0};
-		    }
-		    ListVector::Reserve(result, result_size + compact_result.len);
-		    for (size_t i = 0; i < compact_result.len; i++) {
-			    ListVector::PushBack(result, Value::UBIGINT(compact_result.data[i]));
-		    }
-		    result_size += compact_result.len;
+		    return writer.Write(
+		        [&](CellSink sink, void *ctx) {
+			        return a5_uncompact_into(cell_list_data + cell_list_entry.offset, cell_list_entry.length,
+			                                 target_resolution, sink, ctx);
+		        },
+		        "a5_uncompact");
+	    });
+}
 
-		    list_entry_t out {offset, compact_result.len};
-		    offset += compact_result.len;
-		    a5_free_cell_array(compact_result);
-		    return out;
+struct A5CellsUnion {
+	static constexpr const char *NAME = "a5_cells_union";
+	static void Operation(A5CellSetOperations &operations, const uint64_t *a, idx_t a_count, const uint64_t *b,
+	                      idx_t b_count, vector<uint64_t> &out) {
+		operations.Union(a, a_count, b, b_count, out);
+	}
+};
+
+struct A5CellsIntersection {
+	static constexpr const char *NAME = "a5_cells_intersection";
+	static void Operation(A5CellSetOperations &operations, const uint64_t *a, idx_t a_count, const uint64_t *b,
+	                      idx_t b_count, vector<uint64_t> &out) {
+		operations.Intersection(a, a_count, b, b_count, out);
+	}
+};
+
+struct A5CellsDifference {
+	static constexpr const char *NAME = "a5_cells_difference";
+	static void Operation(A5CellSetOperations &operations, const uint64_t *a, idx_t a_count, const uint64_t *b,
+	                      idx_t b_count, vector<uint64_t> &out) {
+		operations.Difference(a, a_count, b, b_count, out);
+	}
+};
+
+template <class OP>
+inline void A5CellSetOperationFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &a_vector = args.data[0];
+	auto &b_vector = args.data[1];
+
+	A5CellListWriter writer(result);
+	A5CellSetOperations operations(OP::NAME);
+	vector<uint64_t> cells;
+
+	auto a_data = FlatVector::GetData<uint64_t>(ListVector::GetEntry(a_vector));
+	auto b_data = FlatVector::GetData<uint64_t>(ListVector::GetEntry(b_vector));
+
+	BinaryExecutor::Execute<list_entry_t, list_entry_t, list_entry_t>(
+	    a_vector, b_vector, result, args.size(), [&](list_entry_t a_entry, list_entry_t b_entry) {
+		    OP::Operation(operations, a_data + a_entry.offset, a_entry.length, b_data + b_entry.offset,
+		                  b_entry.length, cells);
+		    return writer.WriteValues(cells);
+	    });
+}
+
+inline void A5CellsContainsFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &cell_list_vector = args.data[0];
+	auto &cell_vector = args.data[1];
+
+	A5CellSetOperations operations("a5_cells_contains");
+	auto cell_list_data = FlatVector::GetData<uint64_t>(ListVector::GetEntry(cell_list_vector));
+
+	BinaryExecutor::Execute<list_entry_t, uint64_t, bool>(
+	    cell_list_vector, cell_vector, result, args.size(), [&](list_entry_t cell_list_entry, uint64_t cell) {
+		    return operations.Covers(cell_list_data + cell_list_entry.offset, cell_list_entry.length, cell);
 	    });
 }
 
+template <bool TRY>
 inline void A5HexToU64Fun(DataChunk &args, ExpressionState &state, Vector &result) {
 	auto &hex_vector = args.data[0];
-	UnaryExecutor::Execute<string_t, uint64_t>(hex_vector, result, args.size(), [&](string_t hex) {
-		struct ResultU64 res = a5_hex_to_u64(hex.GetString().c_str());
-		ThrowRustError(res.error, "a5_hex_to_u64");
-		return res.value;
-	});
+	UnaryExecutor::ExecuteWithNulls<string_t, uint64_t>(
+	    hex_vector, result, args.size(), [&](string_t hex, ValidityMask &mask, idx_t idx) {
+		    // Well-formed cells are decoded straight from the string payload; anything else is left to
+		    // the a5 crate for its result or error message
+		    uint64_t cell;
+		    if (A5DecodeHex(hex.GetData(), hex.GetSize(), cell)) {
+			    return cell;
+		    }
+		    struct ResultU64 res = a5_hex_to_u64(hex.GetData(), hex.GetSize());
+		    if (TRY && res.error_code != A5_OK) {
+			    mask.SetInvalid(idx);
+			    return uint64_t(0);
+		    }
+		    ThrowRustError(res.error_code, "a5_hex_to_u64");
+		    return res.value;
+	    });
 }
 
 inline void A5U64ToHexFun(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto &cell_vector = args.data[0];
-
-	UnifiedVectorFormat cell_format;
-	cell_vector.ToUnifiedFormat(args.size(), cell_format);
-	auto input_data = UnifiedVectorFormat::GetData<uint64_t>(cell_format);
-
-	for (idx_t i = 0; i < args.size(); i++) {
-		auto idx = cell_format.sel->get_index(i);
-		if (!cell_format.validity.RowIsValid(idx)) {
-			FlatVector::SetNull(result, i, true);
-			continue;
-		}
-		char *hex_ptr = a5_u64_to_hex(input_data[idx]);
-		string hex_str(hex_ptr);
-		a5_free_string(hex_ptr);
-		FlatVector::GetData<string_t>(result)[i] = StringVector::AddString(result, hex_str);
-	}
-
-	if (args.size() == 1) {
-		result.SetVectorType(VectorType::CONSTANT_VECTOR);
-	}
+	UnaryExecutor::Execute<uint64_t, string_t>(args.data[0], result, args.size(), [&](uint64_t cell) {
+		char buffer[A5_MAX_HEX_LENGTH];
+		auto length = A5EncodeHex(cell, buffer);
+		return StringVector::AddString(result, buffer, length);
+	});
 }
 
 inline void A5GetNumChildrenFun(DataChunk &args, ExpressionState &state, Vector &result) {
@@ -363,68 +944,64 @@ inline void A5GetNumChildrenFun(DataChunk &args, ExpressionState &state, Vector
 	    parent_res_vector, child_res_vector, result, args.size(), [&](int32_t parent_res, int32_t child_res) {
 		    ValidateResolution(parent_res, "a5_get_num_children");
 		    ValidateResolution(child_res, "a5_get_num_children");
+		    if (child_res >= parent_res) {
+			    return a5_index::NumChildren(parent_res, child_res);
+		    }
 		    return static_cast<uint64_t>(a5_get_num_children(parent_res, child_res));
 	    });
 }
 
 inline void A5CellToSphericalFun(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto &cell_vector = args.data[0];
-
-	auto &result_data_children = ArrayVector::GetEntry(result);
-	double *data_ptr = FlatVector::GetData<double>(result_data_children);
-
-	UnifiedVectorFormat cell_id_format;
-	cell_vector.ToUnifiedFormat(args.size(), cell_id_format);
-	uint64_t *input_data_ptr = FlatVector::GetData<uint64_t>(cell_vector);
-
-	for (idx_t i = 0; i < args.size(); i++) {
-		auto cell_idx = cell_id_format.sel->get_index(i);
-		if (!cell_id_format.validity.RowIsValid(cell_idx)) {
-			FlatVector::SetNull(result, i, true);
-			continue;
-		}
-
-		struct ResultSpherical res = a5_cell_to_spherical(input_data_ptr[cell_idx]);
-		ThrowRustError(res.error, "a5_cell_to_spherical");
+	A5CellToPairExecute<false, ResultSpherical, a5_cell_to_spherical, a5_cell_to_spherical_batch>(
+	    args.data[0], args.size(), result, "a5_cell_to_spherical");
+}
 
-		data_ptr[i * 2] = res.theta;
-		data_ptr[i * 2 + 1] = res.phi;
+// Writes the neighborhood of (cell, param) into the result, serving repeated arguments from the
+// thread's cache. `fill` computes the neighborhood through one of the Rust `*_into` entry points.
+template <class FUNC>
+list_entry_t A5WriteNeighborhood(A5CellListWriter &writer, A5NeighborhoodCache &cache, uint64_t cell, uint64_t param,
+                                 FUNC &&fill, const char *function_name, idx_t &hits, idx_t &misses) {
+	if (!cache.Enabled()) {
+		return writer.Write(fill, function_name);
 	}
-
-	if (args.size() == 1) {
-		result.SetVectorType(VectorType::CONSTANT_VECTOR);
+	auto cached = cache.Find(cell, param);
+	if (cached) {
+		hits++;
+		return writer.WriteValues(*cached);
 	}
+	misses++;
+	// Written straight into the list, then copied into the cache if it is small enough to keep
+	auto entry = writer.Write(fill, function_name);
+	cache.Insert(cell, param, writer.Data(entry), entry.length);
+	return entry;
 }
 
 inline void A5SphericalCapFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &cache = ExecuteFunctionState::GetFunctionState(state)->Cast<A5NeighborhoodLocalState>().cache;
 	ListVector::Reserve(result, args.size() * 4);
-	uint64_t offset = 0;
+	A5CellListWriter writer(result);
+	idx_t hits = 0, misses = 0;
 
 	auto &cell_vector = args.data[0];
 	auto &radius_vector = args.data[1];
 
 	BinaryExecutor::Execute<uint64_t, double, list_entry_t>(
 	    cell_vector, radius_vector, result, args.size(), [&](uint64_t cell_id, double radius) {
-		    auto cap_result = a5_spherical_cap(cell_id, radius);
-		    ThrowCellArrayError(cap_result, "a5_spherical_cap");
-
-		    if (cap_result.len == 0) {
-			    a5_free_cell_array(cap_result);
-			    return list_entry_t {0, 0};
-		    }
-		    for (size_t i = 0; i < cap_result.len; i++) {
-			    ListVector::PushBack(result, Value::UBIGINT(cap_result.data[i]));
-		    }
-		    list_entry_t out {offset, cap_result.len};
-		    offset += cap_result.len;
-		    a5_free_cell_array(cap_result);
-		    return out;
+		    uint64_t radius_bits;
+		    memcpy(&radius_bits, &radius, sizeof(radius_bits));
+		    return A5WriteNeighborhood(
+		        writer, cache, cell_id, radius_bits,
+		        [&](CellSink sink, void *ctx) { return a5_spherical_cap_into(cell_id, radius, sink, ctx); },
+		        "a5_spherical_cap", hits, misses);
 	    });
+	A5RecordNeighborhoodCacheStats(A5NeighborhoodFunction::SPHERICAL_CAP, hits, misses);
 }
 
 inline void A5GridDiskFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &cache = ExecuteFunctionState::GetFunctionState(state)->Cast<A5NeighborhoodLocalState>().cache;
 	ListVector::Reserve(result, args.size() * 4);
-	uint64_t offset = 0;
+	A5CellListWriter writer(result);
+	idx_t hits = 0, misses = 0;
 
 	auto &cell_vector = args.data[0];
 	auto &k_vector = args.data[1];
@@ -434,26 +1011,21 @@ inline void A5GridDiskFun(DataChunk &args, ExpressionState &state, Vector &resul
 		    if (k < 0) {
 			    throw InvalidInputException("a5_grid_disk: k must be >= 0");
 		    }
-		    auto disk_result = a5_grid_disk(cell_id, static_cast<uintptr_t>(k));
-		    ThrowCellArrayError(disk_result, "a5_grid_disk");
-
-		    if (disk_result.len == 0) {
-			    a5_free_cell_array(disk_result);
-			    return list_entry_t {0, 0};
-		    }
-		    for (size_t i = 0; i < disk_result.len; i++) {
-			    ListVector::PushBack(result, Value::UBIGINT(disk_result.data[i]));
-		    }
-		    list_entry_t out {offset, disk_result.len};
-		    offset += disk_result.len;
-		    a5_free_cell_array(disk_result);
-		    return out;
+		    return A5WriteNeighborhood(
+		        writer, cache, cell_id, static_cast<uint64_t>(k),
+		        [&](CellSink sink, void *ctx) {
+			        return A5GridDiskInto(cell_id, static_cast<uintptr_t>(k), sink, ctx);
+		        },
+		        "a5_grid_disk", hits, misses);
 	    });
+	A5RecordNeighborhoodCacheStats(A5NeighborhoodFunction::GRID_DISK, hits, misses);
 }
 
 inline void A5GridDiskVertexFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &cache = ExecuteFunctionState::GetFunctionState(state)->Cast<A5NeighborhoodLocalState>().cache;
 	ListVector::Reserve(result, args.size() * 4);
-	uint64_t offset = 0;
+	A5CellListWriter writer(result);
+	idx_t hits = 0, misses = 0;
 
 	auto &cell_vector = args.data[0];
 	auto &k_vector = args.data[1];
@@ -463,335 +1035,398 @@ inline void A5GridDiskVertexFun(DataChunk &args, ExpressionState &state, Vector
 		    if (k < 0) {
 			    throw InvalidInputException("a5_grid_disk_vertex: k must be >= 0");
 		    }
-		    auto disk_result = a5_grid_disk_vertex(cell_id, static_cast<uintptr_t>(k));
-		    ThrowCellArrayError(disk_result, "a5_grid_disk_vertex");
+		    return A5WriteNeighborhood(
+		        writer, cache, cell_id, static_cast<uint64_t>(k),
+		        [&](CellSink sink, void *ctx) {
+			        return a5_grid_disk_vertex_into(cell_id, static_cast<uintptr_t>(k), sink, ctx);
+		        },
+		        "a5_grid_disk_vertex", hits, misses);
+	    });
+	A5RecordNeighborhoodCacheStats(A5NeighborhoodFunction::GRID_DISK_VERTEX, hits, misses);
+}
+
+inline void A5GridRingFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &cache = ExecuteFunctionState::GetFunctionState(state)->Cast<A5NeighborhoodLocalState>().cache;
+	ListVector::Reserve(result, args.size() * 4);
+	A5CellListWriter writer(result);
+	A5GridRingExpander expander("a5_grid_ring");
+	idx_t hits = 0, misses = 0;
 
-		    if (disk_result.len == 0) {
-			    a5_free_cell_array(disk_result);
-			    return list_entry_t {0, 0};
+	auto &cell_vector = args.data[0];
+	auto &k_vector = args.data[1];
+
+	BinaryExecutor::Execute<uint64_t, int32_t, list_entry_t>(
+	    cell_vector, k_vector, result, args.size(), [&](uint64_t cell_id, int32_t k) {
+		    if (k < 0) {
+			    throw InvalidInputException("a5_grid_ring: k must be >= 0");
 		    }
-		    for (size_t i = 0; i < disk_result.len; i++) {
-			    ListVector::PushBack(result, Value::UBIGINT(disk_result.data[i]));
+		    if (!A5IsValidCell(cell_id)) {
+			    throw InvalidInputException("a5_grid_ring: invalid cell %llu", cell_id);
 		    }
-		    list_entry_t out {offset, disk_result.len};
-		    offset += disk_result.len;
-		    a5_free_cell_array(disk_result);
-		    return out;
+		    return A5WriteNeighborhood(
+		        writer, cache, cell_id, static_cast<uint64_t>(k),
+		        [&](CellSink sink, void *ctx) {
+			        expander.Reset(cell_id);
+			        expander.AdvanceTo(k);
+			        auto &ring = expander.Ring();
+			        auto out = sink(ctx, ring.size());
+			        if (!out) {
+				        return A5_ERROR_ALLOCATION;
+			        }
+			        memcpy(out, ring.data(), ring.size() * sizeof(uint64_t));
+			        return A5_OK;
+		        },
+		        "a5_grid_ring", hits, misses);
 	    });
+	A5RecordNeighborhoodCacheStats(A5NeighborhoodFunction::GRID_RING, hits, misses);
 }
 
-static void LoadInternal(ExtensionLoader &loader) {
-	// a5_cell_area: Returns the area of a cell at a given resolution
-	{
-		auto func = ScalarFunction("a5_cell_area", {LogicalType::INTEGER}, LogicalType::DOUBLE, A5CellAreaFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns the area in square meters of an A5 cell at the specified resolution level";
-		desc.parameter_names = {"resolution"};
-		desc.parameter_types = {LogicalType::INTEGER};
-		desc.examples = {"a5_cell_area(10)"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_get_num_cells: Returns the total number of cells at a given resolution
-	{
-		auto func = ScalarFunction("a5_get_num_cells", {LogicalType::INTEGER}, LogicalType::UBIGINT, A5GetNumCellsFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns the total number of A5 cells at the specified resolution level (0-30)";
-		desc.parameter_names = {"resolution"};
-		desc.parameter_types = {LogicalType::INTEGER};
-		desc.examples = {"a5_get_num_cells(5)"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_get_resolution: Returns the resolution of a cell
-	{
-		auto func =
-		    ScalarFunction("a5_get_resolution", {LogicalType::UBIGINT}, LogicalType::INTEGER, A5GetResolutionFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns the resolution level (0-30) of an A5 cell";
-		desc.parameter_names = {"cell"};
-		desc.parameter_types = {LogicalType::UBIGINT};
-		desc.examples = {"a5_get_resolution(a5_lonlat_to_cell(-122.4, 37.8, 10))"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_lonlat_to_cell: Converts longitude/latitude to a cell
-	{
-		auto func =
-		    ScalarFunction("a5_lonlat_to_cell", {LogicalType::DOUBLE, LogicalType::DOUBLE, LogicalType::INTEGER},
-		                   LogicalType::UBIGINT, A5LonLatToCellFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Converts a longitude/latitude coordinate to an A5 cell at the specified resolution";
-		desc.parameter_names = {"longitude", "latitude", "resolution"};
-		desc.parameter_types = {LogicalType::DOUBLE, LogicalType::DOUBLE, LogicalType::INTEGER};
-		desc.examples = {"a5_lonlat_to_cell(-122.4194, 37.7749, 10)"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_cell_to_parent: Returns the parent cell at a given resolution
-	{
-		auto func = ScalarFunction("a5_cell_to_parent", {LogicalType::UBIGINT, LogicalType::INTEGER},
-		                           LogicalType::UBIGINT, A5CellToParentFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns the parent A5 cell at the specified coarser resolution";
-		desc.parameter_names = {"cell", "parent_resolution"};
-		desc.parameter_types = {LogicalType::UBIGINT, LogicalType::INTEGER};
-		desc.examples = {"a5_cell_to_parent(a5_lonlat_to_cell(-122.4, 37.8, 10), 5)"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_cell_to_lonlat: Returns the center longitude/latitude of a cell
-	{
-		auto func = ScalarFunction("a5_cell_to_lonlat", {LogicalType::UBIGINT},
-		                           LogicalType::ARRAY(LogicalType::DOUBLE, 2), A5CellToLonLatFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns the center point [longitude, latitude] of an A5 cell";
-		desc.parameter_names = {"cell"};
-		desc.parameter_types = {LogicalType::UBIGINT};
-		desc.examples = {"a5_cell_to_lonlat(a5_lonlat_to_cell(-122.4, 37.8, 10))"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_cell_to_children: Returns child cells
-	{
-		ScalarFunctionSet func_set("a5_cell_to_children");
-		func_set.AddFunction(ScalarFunction("a5_cell_to_children", {LogicalType::UBIGINT, LogicalType::INTEGER},
-		                                    LogicalType::LIST(LogicalType::UBIGINT), A5CellToChildrenFun));
-		func_set.AddFunction(ScalarFunction("a5_cell_to_children", {LogicalType::UBIGINT},
-		                                    LogicalType::LIST(LogicalType::UBIGINT), A5CellToChildrenFun));
-		CreateScalarFunctionInfo info(func_set);
-
-		// Description for two-argument variant
-		FunctionDescription desc1;
-		desc1.description = "Returns all child A5 cells at the specified finer resolution";
-		desc1.parameter_names = {"cell", "child_resolution"};
-		desc1.parameter_types = {LogicalType::UBIGINT, LogicalType::INTEGER};
-		desc1.examples = {"a5_cell_to_children(a5_lonlat_to_cell(-122.4, 37.8, 5), 6)"};
-		desc1.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc1));
-
-		// Description for one-argument variant (immediate children)
-		FunctionDescription desc2;
-		desc2.description = "Returns the immediate child A5 cells (one resolution finer)";
-		desc2.parameter_names = {"cell"};
-		desc2.parameter_types = {LogicalType::UBIGINT};
-		desc2.examples = {"a5_cell_to_children(a5_lonlat_to_cell(-122.4, 37.8, 5))"};
-		desc2.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc2));
-
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_get_res0_cells: Returns all resolution 0 cells
-	{
-		auto func = ScalarFunction("a5_get_res0_cells", {}, LogicalType::LIST(LogicalType::UBIGINT), A5GetRes0CellsFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns all 12 resolution 0 (root) A5 cells covering the entire globe";
-		desc.parameter_names = {};
-		desc.parameter_types = {};
-		desc.examples = {"a5_get_res0_cells()"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_cell_to_boundary: Returns the boundary polygon vertices
-	{
-		ScalarFunctionSet func_set("a5_cell_to_boundary");
-		func_set.AddFunction(ScalarFunction({LogicalType::UBIGINT},
-		                                    LogicalType::LIST(LogicalType::ARRAY(LogicalType::DOUBLE, 2)),
-		                                    A5CellToBoundaryFun));
-		func_set.AddFunction(ScalarFunction({LogicalType::UBIGINT, LogicalType::BOOLEAN},
-		                                    LogicalType::LIST(LogicalType::ARRAY(LogicalType::DOUBLE, 2)),
-		                                    A5CellToBoundaryFun));
-		func_set.AddFunction(ScalarFunction({LogicalType::UBIGINT, LogicalType::BOOLEAN, LogicalType::INTEGER},
-		                                    LogicalType::LIST(LogicalType::ARRAY(LogicalType::DOUBLE, 2)),
-		                                    A5CellToBoundaryFun));
-		CreateScalarFunctionInfo info(func_set);
-
-		// Description for one-argument variant
-		FunctionDescription desc1;
-		desc1.description = "Returns the boundary vertices of an A5 cell as a closed ring of [lon, lat] points";
-		desc1.parameter_names = {"cell"};
-		desc1.parameter_types = {LogicalType::UBIGINT};
-		desc1.examples = {"a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 5))"};
-		desc1.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc1));
-
-		// Description for two-argument variant
-		FunctionDescription desc2;
-		desc2.description = "Returns the boundary vertices of an A5 cell, optionally as an open or closed ring";
-		desc2.parameter_names = {"cell", "closed_ring"};
-		desc2.parameter_types = {LogicalType::UBIGINT, LogicalType::BOOLEAN};
-		desc2.examples = {"a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 5), false)"};
-		desc2.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc2));
-
-		// Description for three-argument variant
-		FunctionDescription desc3;
-		desc3.description = "Returns the boundary vertices of an A5 cell with configurable ring closure and edge "
-		                    "interpolation segments";
-		desc3.parameter_names = {"cell", "closed_ring", "segments"};
-		desc3.parameter_types = {LogicalType::UBIGINT, LogicalType::BOOLEAN, LogicalType::INTEGER};
-		desc3.examples = {"a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 5), true, 4)"};
-		desc3.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc3));
-
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_compact: Compacts a set of cells
-	{
-		auto func = ScalarFunction("a5_compact", {LogicalType::LIST(LogicalType::UBIGINT)},
-		                           LogicalType::LIST(LogicalType::UBIGINT), A5CompactFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Compacts a list of A5 cells by merging complete sets of sibling cells into parent cells";
-		desc.parameter_names = {"cells"};
-		desc.parameter_types = {LogicalType::LIST(LogicalType::UBIGINT)};
-		desc.examples = {"a5_compact(a5_cell_to_children(a5_lonlat_to_cell(-122.4, 37.8, 5)))"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_uncompact: Uncompacts cells to a target resolution
-	{
-		auto func = ScalarFunction("a5_uncompact", {LogicalType::LIST(LogicalType::UBIGINT), LogicalType::INTEGER},
-		                           LogicalType::LIST(LogicalType::UBIGINT), A5UncompactFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Expands a compacted list of A5 cells to the specified target resolution";
-		desc.parameter_names = {"cells", "target_resolution"};
-		desc.parameter_types = {LogicalType::LIST(LogicalType::UBIGINT), LogicalType::INTEGER};
-		desc.examples = {"a5_uncompact([a5_lonlat_to_cell(-122.4, 37.8, 5)], 7)"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_hex_to_u64: Converts a hex string to a u64 cell ID
-	{
-		auto func = ScalarFunction("a5_hex_to_u64", {LogicalType::VARCHAR}, LogicalType::UBIGINT, A5HexToU64Fun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Converts an A5 hex string representation to a UBIGINT cell ID";
-		desc.parameter_names = {"hex"};
-		desc.parameter_types = {LogicalType::VARCHAR};
-		desc.examples = {"a5_hex_to_u64('1600000000000000')"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_u64_to_hex: Converts a u64 cell ID to a hex string
-	{
-		auto func = ScalarFunction("a5_u64_to_hex", {LogicalType::UBIGINT}, LogicalType::VARCHAR, A5U64ToHexFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Converts a UBIGINT A5 cell ID to its hex string representation";
-		desc.parameter_names = {"cell"};
-		desc.parameter_types = {LogicalType::UBIGINT};
-		desc.examples = {"a5_u64_to_hex(a5_lonlat_to_cell(-122.4, 37.8, 10))"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_get_num_children: Returns the number of children between two resolutions
-	{
-		auto func = ScalarFunction("a5_get_num_children", {LogicalType::INTEGER, LogicalType::INTEGER},
-		                           LogicalType::UBIGINT, A5GetNumChildrenFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description =
-		    "Returns the number of child cells at child_resolution that fit within a cell at parent_resolution";
-		desc.parameter_names = {"parent_resolution", "child_resolution"};
-		desc.parameter_types = {LogicalType::INTEGER, LogicalType::INTEGER};
-		desc.examples = {"a5_get_num_children(0, 1)"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_cell_to_spherical: Returns the spherical coordinates of a cell center
-	{
-		auto func = ScalarFunction("a5_cell_to_spherical", {LogicalType::UBIGINT},
-		                           LogicalType::ARRAY(LogicalType::DOUBLE, 2), A5CellToSphericalFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns the spherical coordinates [theta, phi] in radians of an A5 cell center";
-		desc.parameter_names = {"cell"};
-		desc.parameter_types = {LogicalType::UBIGINT};
-		desc.examples = {"a5_cell_to_spherical(a5_lonlat_to_cell(-122.4, 37.8, 10))"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_spherical_cap: Returns cells within a spherical cap radius
-	{
-		auto func = ScalarFunction("a5_spherical_cap", {LogicalType::UBIGINT, LogicalType::DOUBLE},
-		                           LogicalType::LIST(LogicalType::UBIGINT), A5SphericalCapFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns all A5 cells within the specified radius (in meters) of the given cell";
-		desc.parameter_names = {"cell", "radius"};
-		desc.parameter_types = {LogicalType::UBIGINT, LogicalType::DOUBLE};
-		desc.examples = {"a5_spherical_cap(a5_lonlat_to_cell(-122.4, 37.8, 10), 1000.0)"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_grid_disk: Returns cells within k edge-distance of the given cell
-	{
-		auto func = ScalarFunction("a5_grid_disk", {LogicalType::UBIGINT, LogicalType::INTEGER},
-		                           LogicalType::LIST(LogicalType::UBIGINT), A5GridDiskFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns all A5 cells within k edge-steps of the given cell (edge adjacency)";
-		desc.parameter_names = {"cell", "k"};
-		desc.parameter_types = {LogicalType::UBIGINT, LogicalType::INTEGER};
-		desc.examples = {"a5_grid_disk(a5_lonlat_to_cell(-122.4, 37.8, 10), 1)"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
-	}
-
-	// a5_grid_disk_vertex: Returns cells within k vertex-distance of the given cell
-	{
-		auto func = ScalarFunction("a5_grid_disk_vertex", {LogicalType::UBIGINT, LogicalType::INTEGER},
-		                           LogicalType::LIST(LogicalType::UBIGINT), A5GridDiskVertexFun);
-		CreateScalarFunctionInfo info(func);
-		FunctionDescription desc;
-		desc.description = "Returns all A5 cells within k vertex-steps of the given cell (vertex adjacency)";
-		desc.parameter_names = {"cell", "k"};
-		desc.parameter_types = {LogicalType::UBIGINT, LogicalType::INTEGER};
-		desc.examples = {"a5_grid_disk_vertex(a5_lonlat_to_cell(-122.4, 37.8, 10), 1)"};
-		desc.categories = {"a5", "geospatial"};
-		info.descriptions.push_back(std::move(desc));
-		loader.RegisterFunction(std::move(info));
+// Cells of resolutions up to this one are all measured by A5MaxCellCircumradius; resolution 6 has 61,440
+static constexpr int32_t A5_MEASURED_CIRCUMRADIUS_RESOLUTION = 6;
+
+// Boundary points sampled per edge when measuring, and the allowance for the edge bulging between them
+static constexpr int32_t A5_CIRCUMRADIUS_SEGMENTS = 8;
+static constexpr double A5_CIRCUMRADIUS_MARGIN = 0.05;
+
+static double A5GreatCircleDistance(double lon1, double lat1, double lon2, double lat2) {
+	static constexpr double RADIANS = 3.14159265358979323846 / 180.0;
+	auto sin_lat = std::sin((lat2 - lat1) * RADIANS / 2);
+	auto sin_lon = std::sin((lon2 - lon1) * RADIANS / 2);
+	auto h = sin_lat * sin_lat + std::cos(lat1 * RADIANS) * std::cos(lat2 * RADIANS) * sin_lon * sin_lon;
+	return 2 * a5_index::AUTHALIC_RADIUS * std::asin(std::sqrt(MinValue(h, 1.0)));
+}
+
+static double A5MeasureCircumradius(int32_t resolution) {
+	CellBoundaryOptions options;
+	options.closed_ring = false;
+	options.segments = A5_CIRCUMRADIUS_SEGMENTS;
+	vector<LonLatDegrees> ring;
+	double result = 0;
+	for (uint64_t offset = 0; offset < a5_index::NumCells(resolution); offset++) {
+		auto cell = a5_index::OffsetToCell(offset, resolution);
+		auto center = a5_cell_to_lon_lat(cell);
+		ThrowRustError(center.error_code, "a5_cell_circumradius");
+		ring.clear();
+		ThrowRustError(a5_cell_to_boundary_into(cell, options, A5VectorSink<LonLatDegrees>, &ring),
+		               "a5_cell_circumradius");
+		for (auto &point : ring) {
+			result = MaxValue(result,
+			                  A5GreatCircleDistance(center.longitude, center.latitude, point.lon, point.lat));
+		}
+	}
+	return result * (1 + A5_CIRCUMRADIUS_MARGIN);
+}
+
+double A5MaxCellCircumradius(int32_t resolution) {
+	// Resolutions up to A5_MEASURED_CIRCUMRADIUS_RESOLUTION are measured over every cell. Each level
+	// below splits a cell into four that halve it in the face plane, so finer bounds follow by halving
+	// while allowing for the largest ratio between consecutive measured levels, beyond the ideal 1/2,
+	// at every level.
+	static double bounds[MAX_RESOLUTION + 1];
+	static std::once_flag measured;
+	std::call_once(measured, [] {
+		for (int32_t r = 0; r <= A5_MEASURED_CIRCUMRADIUS_RESOLUTION; r++) {
+			bounds[r] = A5MeasureCircumradius(r);
+		}
+		double ratio = 0.5;
+		for (int32_t r = a5_index::FIRST_HILBERT_RESOLUTION + 1; r <= A5_MEASURED_CIRCUMRADIUS_RESOLUTION; r++) {
+			ratio = MaxValue(ratio, bounds[r] / bounds[r - 1]);
+		}
+		for (int32_t r = A5_MEASURED_CIRCUMRADIUS_RESOLUTION + 1; r <= MAX_RESOLUTION; r++) {
+			bounds[r] = bounds[r - 1] * ratio;
+		}
+	});
+	return bounds[resolution];
+}
+
+// Expands rings around the first cell until the second one is reached
+inline void A5GridDistanceFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	A5GridRingExpander expander("a5_grid_distance");
+
+	BinaryExecutor::Execute<uint64_t, uint64_t, int32_t>(
+	    args.data[0], args.data[1], result, args.size(), [&](uint64_t a, uint64_t b) {
+		    if (!A5IsValidCell(a) || !A5IsValidCell(b)) {
+			    throw InvalidInputException("a5_grid_distance: invalid cell %llu", A5IsValidCell(a) ? b : a);
+		    }
+		    if (a == b) {
+			    return 0;
+		    }
+		    auto resolution = A5GetResolution(a);
+		    if (resolution != A5GetResolution(b)) {
+			    throw InvalidInputException("a5_grid_distance: cells must have the same resolution (%d and %d)",
+			                                resolution, A5GetResolution(b));
+		    }
+		    // Adjacent cells share an edge point, so one step moves the center at most two circumradii; pairs
+		    // further apart than the search reaches fail before any ring is expanded
+		    auto center_a = a5_cell_to_lon_lat(a);
+		    auto center_b = a5_cell_to_lon_lat(b);
+		    if (center_a.error_code == A5_OK && center_b.error_code == A5_OK &&
+		        A5GreatCircleDistance(center_a.longitude, center_a.latitude, center_b.longitude, center_b.latitude) >
+		            2 * A5MaxCellCircumradius(resolution) * A5_MAX_GRID_DISTANCE) {
+			    throw InvalidInputException("a5_grid_distance: cells are more than %d steps apart",
+			                                A5_MAX_GRID_DISTANCE);
+		    }
+		    expander.Reset(a);
+		    while (expander.K() < A5_MAX_GRID_DISTANCE) {
+			    expander.Next();
+			    auto &ring = expander.Ring();
+			    if (std::binary_search(ring.begin(), ring.end(), b)) {
+				    return expander.K();
+			    }
+		    }
+		    throw InvalidInputException("a5_grid_distance: cells are more than %d steps apart", A5_MAX_GRID_DISTANCE);
+	    });
+}
+
+// Reads the bounds of an INTEGER resolution argument, clamped to the valid range. Returns false when
+// nothing is known or no valid resolution is possible (the function throws for every row then).
+static bool A5ResolutionBounds(BaseStatistics &stats, int32_t &min_resolution, int32_t &max_resolution) {
+	if (!NumericStats::HasMinMax(stats)) {
+		return false;
 	}
+	min_resolution = MaxValue<int32_t>(NumericStats::GetMin<int32_t>(stats), 0);
+	max_resolution = MinValue<int32_t>(NumericStats::GetMax<int32_t>(stats), MAX_RESOLUTION);
+	return min_resolution <= max_resolution;
+}
+
+static unique_ptr<BaseStatistics> A5CellStatistics(FunctionStatisticsInput &input, uint64_t min_cell, uint64_t max_cell) {
+	auto stats = NumericStats::CreateUnknown(input.expr.return_type);
+	NumericStats::SetMin(stats, Value::UBIGINT(min_cell));
+	NumericStats::SetMax(stats, Value::UBIGINT(max_cell));
+	return stats.ToUnique();
+}
+
+// Smallest and largest index a cell at the resolution can take
+static void A5CellBoundsAtResolution(int32_t resolution, uint64_t &min_cell, uint64_t &max_cell) {
+	if (resolution > a5_index::MAX_INLINE_RESOLUTION) {
+		min_cell = 0;
+		max_cell = (a5_index::NUM_ORIGINS * a5_index::SEGMENTS_PER_ORIGIN << a5_index::HILBERT_START_BIT) - 1;
+		return;
+	}
+	auto marker = uint64_t(1) << a5_index::MarkerBit(resolution);
+	min_cell = marker;
+	if (resolution == 0) {
+		max_cell = ((a5_index::NUM_ORIGINS - 1) << a5_index::HILBERT_START_BIT) | marker;
+		return;
+	}
+	auto last_prefix = a5_index::NUM_ORIGINS * a5_index::SEGMENTS_PER_ORIGIN - 1;
+	max_cell = (last_prefix << a5_index::HILBERT_START_BIT) | ((uint64_t(1) << a5_index::HILBERT_START_BIT) - marker);
+}
+
+// a5_lonlat_to_cell(lon, lat, resolution): the resolution bounds limit the marker bit position
+static unique_ptr<BaseStatistics> A5LonLatToCellStatistics(ClientContext &context, FunctionStatisticsInput &input) {
+	int32_t min_resolution, max_resolution;
+	if (!A5ResolutionBounds(input.child_stats[2], min_resolution, max_resolution)) {
+		return nullptr;
+	}
+	uint64_t min_cell = NumericLimits<uint64_t>::Maximum();
+	uint64_t max_cell = 0;
+	for (auto resolution = min_resolution; resolution <= max_resolution; resolution++) {
+		uint64_t lo, hi;
+		A5CellBoundsAtResolution(resolution, lo, hi);
+		min_cell = MinValue(min_cell, lo);
+		max_cell = MaxValue(max_cell, hi);
+	}
+	return A5CellStatistics(input, min_cell, max_cell);
+}
+
+// a5_cell_to_parent(cell, resolution): truncation is monotonic, so a constant target resolution maps
+// the bounds of the input cells onto bounds of their parents
+static unique_ptr<BaseStatistics> A5CellToParentStatistics(ClientContext &context, FunctionStatisticsInput &input) {
+	int32_t min_resolution, max_resolution;
+	if (!A5ResolutionBounds(input.child_stats[1], min_resolution, max_resolution)) {
+		return nullptr;
+	}
+	auto &cell_stats = input.child_stats[0];
+	if (min_resolution == max_resolution && min_resolution <= a5_index::MAX_INLINE_RESOLUTION &&
+	    NumericStats::HasMinMax(cell_stats)) {
+		return A5CellStatistics(
+		    input, a5_index::TruncateToResolution(NumericStats::GetMin<uint64_t>(cell_stats), min_resolution),
+		    a5_index::TruncateToResolution(NumericStats::GetMax<uint64_t>(cell_stats), min_resolution));
+	}
+	uint64_t min_cell = NumericLimits<uint64_t>::Maximum();
+	uint64_t max_cell = 0;
+	for (auto resolution = min_resolution; resolution <= max_resolution; resolution++) {
+		uint64_t lo, hi;
+		A5CellBoundsAtResolution(resolution, lo, hi);
+		min_cell = MinValue(min_cell, lo);
+		max_cell = MaxValue(max_cell, hi);
+	}
+	return A5CellStatistics(input, min_cell, max_cell);
+}
+
+// a5_get_resolution(cell) is always between 0 and 30
+static unique_ptr<BaseStatistics> A5GetResolutionStatistics(ClientContext &context, FunctionStatisticsInput &input) {
+	auto stats = NumericStats::CreateUnknown(input.expr.return_type);
+	NumericStats::SetMin(stats, Value::INTEGER(0));
+	NumericStats::SetMax(stats, Value::INTEGER(MAX_RESOLUTION));
+	stats.CopyValidity(input.child_stats[0]);
+	return stats.ToUnique();
+}
+
+// Every scalar function of this file with its documentation; overloads are consecutive entries
+static const A5ScalarFunctionEntry A5_SCALAR_FUNCTIONS[] = {
+    {"a5_cell_area", {A5Type::INTEGER}, A5Type::DOUBLE, A5UnaryFun<int32_t, double, A5CellArea>,
+     "Returns the area in square meters of an A5 cell at the specified resolution level", {"resolution"},
+     "a5_cell_area(10)"},
+    {"a5_get_num_cells", {A5Type::INTEGER}, A5Type::UBIGINT, A5UnaryFun<int32_t, uint64_t, A5GetNumCells>,
+     "Returns the total number of A5 cells at the specified resolution level (0-30)", {"resolution"},
+     "a5_get_num_cells(5)"},
+    {"a5_get_resolution", {A5Type::UBIGINT}, A5Type::INTEGER, A5UnaryFun<uint64_t, int32_t, A5GetResolution>,
+     "Returns the resolution level (0-30) of an A5 cell", {"cell"},
+     "a5_get_resolution(a5_lonlat_to_cell(-122.4, 37.8, 10))", A5GetResolutionStatistics},
+    {"a5_is_valid_cell", {A5Type::UBIGINT}, A5Type::BOOLEAN, A5UnaryFun<uint64_t, bool, A5IsValidCell>,
+     "Returns true if the value is a well-formed A5 cell index", {"cell"},
+     "a5_is_valid_cell(a5_lonlat_to_cell(-122.4, 37.8, 10))"},
+    {"a5_lonlat_to_cell", {A5Type::DOUBLE, A5Type::DOUBLE, A5Type::INTEGER}, A5Type::UBIGINT,
+     A5LonLatToCellFun<false>,
+     "Converts a longitude/latitude coordinate to an A5 cell at the specified resolution",
+     {"longitude", "latitude", "resolution"}, "a5_lonlat_to_cell(-122.4194, 37.7749, 10)", A5LonLatToCellStatistics},
+    {"try_a5_lonlat_to_cell", {A5Type::DOUBLE, A5Type::DOUBLE, A5Type::INTEGER}, A5Type::UBIGINT,
+     A5LonLatToCellFun<true>,
+     "Converts a longitude/latitude coordinate to an A5 cell at the specified resolution, returning NULL instead of "
+     "an error for an invalid resolution or coordinate",
+     {"longitude", "latitude", "resolution"}, "try_a5_lonlat_to_cell(-122.4194, 37.7749, 31)",
+     A5LonLatToCellStatistics},
+    {"a5_lonlat_to_cells", {A5Type::DOUBLE, A5Type::DOUBLE, A5Type::INTEGER, A5Type::INTEGER}, A5Type::CELL_LIST,
+     A5LonLatToCellsFun,
+     "Converts a longitude/latitude coordinate to its A5 cells at every resolution from min_resolution to "
+     "max_resolution, coarsest first, projecting the point only once",
+     {"longitude", "latitude", "min_resolution", "max_resolution"}, "a5_lonlat_to_cells(-122.4194, 37.7749, 6, 15)"},
+    {"a5_cell_contains_point", {A5Type::UBIGINT, A5Type::DOUBLE, A5Type::DOUBLE}, A5Type::BOOLEAN,
+     A5ContainsPointFun<false>,
+     "Returns true if a longitude/latitude coordinate lies in the A5 cell, projecting the point at the cell's "
+     "resolution only",
+     {"cell", "longitude", "latitude"}, "a5_cell_contains_point(a5_lonlat_to_cell(-122.4, 37.8, 9), -122.4, 37.8)"},
+    {"a5_cells_contain_point", {A5Type::CELL_LIST, A5Type::DOUBLE, A5Type::DOUBLE}, A5Type::BOOLEAN,
+     A5ContainsPointFun<true>,
+     "Returns true if a longitude/latitude coordinate lies in any cell of a list of A5 cells of any resolutions, "
+     "projecting the point once at the finest resolution of the list",
+     {"cells", "longitude", "latitude"},
+     "a5_cells_contain_point(a5_grid_disk(a5_lonlat_to_cell(-122.4, 37.8, 9), 1), -122.41, 37.79)"},
+    {"a5_cell_to_parent", {A5Type::UBIGINT, A5Type::INTEGER}, A5Type::UBIGINT, A5CellToParentFun<false>,
+     "Returns the parent A5 cell at the specified coarser resolution", {"cell", "parent_resolution"},
+     "a5_cell_to_parent(a5_lonlat_to_cell(-122.4, 37.8, 10), 5)", A5CellToParentStatistics},
+    {"try_a5_cell_to_parent", {A5Type::UBIGINT, A5Type::INTEGER}, A5Type::UBIGINT, A5CellToParentFun<true>,
+     "Returns the parent A5 cell at the specified coarser resolution, or NULL when the cell or the resolution is "
+     "invalid",
+     {"cell", "parent_resolution"}, "try_a5_cell_to_parent(a5_lonlat_to_cell(-122.4, 37.8, 5), 10)",
+     A5CellToParentStatistics},
+    {"a5_cell_to_range", {A5Type::UBIGINT, A5Type::INTEGER}, A5Type::CELL_RANGE, A5CellToRangeFun,
+     "Returns [min, max], the smallest and largest A5 cell index among the descendants of a cell at the target "
+     "resolution; all descendants lie in this contiguous range",
+     {"cell", "target_resolution"}, "a5_cell_to_range(a5_lonlat_to_cell(-122.4, 37.8, 6), 12)"},
+    {"a5_cell_to_lonlat", {A5Type::UBIGINT}, A5Type::POINT, A5CellToLonLatFun<false>,
+     "Returns the center point [longitude, latitude] of an A5 cell", {"cell"},
+     "a5_cell_to_lonlat(a5_lonlat_to_cell(-122.4, 37.8, 10))"},
+    {"try_a5_cell_to_lonlat", {A5Type::UBIGINT}, A5Type::POINT, A5CellToLonLatFun<true>,
+     "Returns the center point [longitude, latitude] of an A5 cell, or NULL when the cell is invalid", {"cell"},
+     "try_a5_cell_to_lonlat(a5_lonlat_to_cell(-122.4, 37.8, 10))"},
+    {"a5_cell_to_children", {A5Type::UBIGINT, A5Type::INTEGER}, A5Type::CELL_LIST, A5CellToChildrenFun,
+     "Returns all child A5 cells at the specified finer resolution", {"cell", "child_resolution"},
+     "a5_cell_to_children(a5_lonlat_to_cell(-122.4, 37.8, 5), 6)"},
+    {"a5_cell_to_children", {A5Type::UBIGINT}, A5Type::CELL_LIST, A5CellToChildrenFun,
+     "Returns the immediate child A5 cells (one resolution finer)", {"cell"},
+     "a5_cell_to_children(a5_lonlat_to_cell(-122.4, 37.8, 5))"},
+    {"a5_get_res0_cells", {}, A5Type::CELL_LIST, A5GetRes0CellsFun,
+     "Returns all 12 resolution 0 (root) A5 cells covering the entire globe", {}, "a5_get_res0_cells()"},
+    {"a5_cell_to_boundary", {A5Type::UBIGINT}, A5Type::RING, A5CellToBoundaryFun<false>,
+     "Returns the boundary vertices of an A5 cell as a closed ring of [lon, lat] points", {"cell"},
+     "a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 5))"},
+    {"a5_cell_to_boundary", {A5Type::UBIGINT, A5Type::BOOLEAN}, A5Type::RING, A5CellToBoundaryFun<false>,
+     "Returns the boundary vertices of an A5 cell, optionally as an open or closed ring", {"cell", "closed_ring"},
+     "a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 5), false)"},
+    {"a5_cell_to_boundary", {A5Type::UBIGINT, A5Type::BOOLEAN, A5Type::INTEGER}, A5Type::RING,
+     A5CellToBoundaryFun<false>,
+     "Returns the boundary vertices of an A5 cell with configurable ring closure and edge interpolation segments",
+     {"cell", "closed_ring", "segments"}, "a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 5), true, 4)"},
+    {"try_a5_cell_to_boundary", {A5Type::UBIGINT}, A5Type::RING, A5CellToBoundaryFun<true>,
+     "Returns the boundary vertices of an A5 cell as a closed ring of [lon, lat] points, or NULL when the cell is "
+     "invalid",
+     {"cell"}, "try_a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 5))"},
+    {"try_a5_cell_to_boundary", {A5Type::UBIGINT, A5Type::BOOLEAN}, A5Type::RING, A5CellToBoundaryFun<true>,
+     "Returns the boundary vertices of an A5 cell as an open or closed ring, or NULL when the cell is invalid",
+     {"cell", "closed_ring"}, "try_a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 5), false)"},
+    {"try_a5_cell_to_boundary", {A5Type::UBIGINT, A5Type::BOOLEAN, A5Type::INTEGER}, A5Type::RING,
+     A5CellToBoundaryFun<true>,
+     "Returns the boundary vertices of an A5 cell with configurable ring closure and edge interpolation segments, "
+     "or NULL when the cell is invalid",
+     {"cell", "closed_ring", "segments"}, "try_a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 5), true, 4)"},
+    {"a5_cell_to_boundary_wkb", {A5Type::UBIGINT}, A5Type::BLOB, A5CellToBoundaryWkbFun,
+     "Returns the boundary of an A5 cell as a WKB polygon", {"cell"},
+     "ST_GeomFromWKB(a5_cell_to_boundary_wkb(a5_lonlat_to_cell(-122.4, 37.8, 5)))", nullptr, A5ArenaInitLocalState},
+    {"a5_cell_to_boundary_wkb", {A5Type::UBIGINT, A5Type::INTEGER}, A5Type::BLOB, A5CellToBoundaryWkbFun,
+     "Returns the boundary of an A5 cell as a WKB polygon with configurable edge interpolation segments",
+     {"cell", "segments"}, "ST_GeomFromWKB(a5_cell_to_boundary_wkb(a5_lonlat_to_cell(-122.4, 37.8, 5), 4))", nullptr,
+     A5ArenaInitLocalState},
+    {"a5_compact", {A5Type::CELL_LIST}, A5Type::CELL_LIST, A5CompactFun,
+     "Compacts a list of A5 cells by merging complete sets of sibling cells into parent cells", {"cells"},
+     "a5_compact(a5_cell_to_children(a5_lonlat_to_cell(-122.4, 37.8, 5)))"},
+    {"a5_uncompact", {A5Type::CELL_LIST, A5Type::INTEGER}, A5Type::CELL_LIST, A5UncompactFun,
+     "Expands a compacted list of A5 cells to the specified target resolution", {"cells", "target_resolution"},
+     "a5_uncompact([a5_lonlat_to_cell(-122.4, 37.8, 5)], 7)"},
+    {"a5_cells_union", {A5Type::CELL_LIST, A5Type::CELL_LIST}, A5Type::CELL_LIST, A5CellSetOperationFun<A5CellsUnion>,
+     "Returns the compacted union of two sets of A5 cells of any resolutions", {"cells_a", "cells_b"},
+     "a5_cells_union(a5_grid_disk(a5_lonlat_to_cell(-122.4, 37.8, 9), 1), [a5_lonlat_to_cell(-122.4, 37.8, 7)])"},
+    {"a5_cells_intersection", {A5Type::CELL_LIST, A5Type::CELL_LIST}, A5Type::CELL_LIST,
+     A5CellSetOperationFun<A5CellsIntersection>,
+     "Returns the compacted intersection of two sets of A5 cells of any resolutions, without expanding them",
+     {"cells_a", "cells_b"},
+     "a5_cells_intersection([a5_lonlat_to_cell(-122.4, 37.8, 5)], a5_grid_disk(a5_lonlat_to_cell(-122.4, 37.8, 8), 1))"},
+    {"a5_cells_difference", {A5Type::CELL_LIST, A5Type::CELL_LIST}, A5Type::CELL_LIST,
+     A5CellSetOperationFun<A5CellsDifference>,
+     "Returns the compacted set of the cells covered by the first set of A5 cells but not by the second",
+     {"cells_a", "cells_b"},
+     "a5_cells_difference([a5_lonlat_to_cell(-122.4, 37.8, 5)], [a5_lonlat_to_cell(-122.4, 37.8, 9)])"},
+    {"a5_cells_contains", {A5Type::CELL_LIST, A5Type::UBIGINT}, A5Type::BOOLEAN, A5CellsContainsFun,
+     "Returns true if a set of A5 cells of any resolutions covers the given cell", {"cells", "cell"},
+     "a5_cells_contains([a5_lonlat_to_cell(-122.4, 37.8, 5)], a5_lonlat_to_cell(-122.4, 37.8, 12))"},
+    {"a5_hex_to_u64", {A5Type::VARCHAR}, A5Type::UBIGINT, A5HexToU64Fun<false>,
+     "Converts an A5 hex string representation to a UBIGINT cell ID", {"hex"}, "a5_hex_to_u64('1600000000000000')"},
+    {"try_a5_hex_to_u64", {A5Type::VARCHAR}, A5Type::UBIGINT, A5HexToU64Fun<true>,
+     "Converts an A5 hex string representation to a UBIGINT cell ID, or NULL when the string is not valid hex",
+     {"hex"}, "try_a5_hex_to_u64('not hex')"},
+    {"a5_u64_to_hex", {A5Type::UBIGINT}, A5Type::VARCHAR, A5U64ToHexFun,
+     "Converts a UBIGINT A5 cell ID to its hex string representation", {"cell"},
+     "a5_u64_to_hex(a5_lonlat_to_cell(-122.4, 37.8, 10))"},
+    {"a5_get_num_children", {A5Type::INTEGER, A5Type::INTEGER}, A5Type::UBIGINT, A5GetNumChildrenFun,
+     "Returns the number of child cells at child_resolution that fit within a cell at parent_resolution",
+     {"parent_resolution", "child_resolution"}, "a5_get_num_children(0, 1)"},
+    {"a5_cell_to_spherical", {A5Type::UBIGINT}, A5Type::POINT, A5CellToSphericalFun,
+     "Returns the spherical coordinates [theta, phi] in radians of an A5 cell center", {"cell"},
+     "a5_cell_to_spherical(a5_lonlat_to_cell(-122.4, 37.8, 10))"},
+    {"a5_spherical_cap", {A5Type::UBIGINT, A5Type::DOUBLE}, A5Type::CELL_LIST, A5SphericalCapFun,
+     "Returns all A5 cells within the specified radius (in meters) of the given cell", {"cell", "radius"},
+     "a5_spherical_cap(a5_lonlat_to_cell(-122.4, 37.8, 10), 1000.0)", nullptr, A5NeighborhoodInitLocalState},
+    {"a5_grid_disk", {A5Type::UBIGINT, A5Type::INTEGER}, A5Type::CELL_LIST, A5GridDiskFun,
+     "Returns all A5 cells within k edge-steps of the given cell (edge adjacency)", {"cell", "k"},
+     "a5_grid_disk(a5_lonlat_to_cell(-122.4, 37.8, 10), 1)", nullptr, A5NeighborhoodInitLocalState},
+    {"a5_grid_ring", {A5Type::UBIGINT, A5Type::INTEGER}, A5Type::CELL_LIST, A5GridRingFun,
+     "Returns the A5 cells exactly k edge-steps from the given cell, keeping only two rings in memory while "
+     "expanding",
+     {"cell", "k"}, "a5_grid_ring(a5_lonlat_to_cell(-122.4, 37.8, 10), 2)", nullptr, A5NeighborhoodInitLocalState},
+    {"a5_grid_distance", {A5Type::UBIGINT, A5Type::UBIGINT}, A5Type::INTEGER, A5GridDistanceFun,
+     "Returns the number of edge-steps between two A5 cells of the same resolution", {"cell_a", "cell_b"},
+     "a5_grid_distance(a5_lonlat_to_cell(-122.4, 37.8, 10), a5_lonlat_to_cell(-122.41, 37.8, 10))"},
+    {"a5_grid_disk_vertex", {A5Type::UBIGINT, A5Type::INTEGER}, A5Type::CELL_LIST, A5GridDiskVertexFun,
+     "Returns all A5 cells within k vertex-steps of the given cell (vertex adjacency)", {"cell", "k"},
+     "a5_grid_disk_vertex(a5_lonlat_to_cell(-122.4, 37.8, 10), 1)", nullptr, A5NeighborhoodInitLocalState},
+};
+
+static void LoadInternal(ExtensionLoader &loader) {
+	A5RegisterScalarFunctions(loader, A5_SCALAR_FUNCTIONS);
+
+	RegisterA5CellType(loader);
+	RegisterA5AggregateFunctions(loader);
+	RegisterA5ScanFunctions(loader);
+	RegisterA5PolyfillFunctions(loader);
+	RegisterA5DissolveFunctions(loader);
+	RegisterA5NeighborhoodCache(loader);
+	RegisterA5SpatialJoinOptimizer(loader);
+	RegisterA5RangeFilterOptimizer(loader);
+	RegisterA5Profiling(loader);
+	RegisterA5LookupTable(loader);
+	RegisterA5Allocator(loader);
 
 	QueryFarmSendTelemetry(loader, "a5", A5_EXTENSION_VERSION);
 }
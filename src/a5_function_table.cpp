@@ -0,0 +1,155 @@
+#include "a5_function_table.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+static LogicalType A5GetLogicalType(A5Type type) {
+	switch (type) {
+	case A5Type::INTEGER:
+		return LogicalType::INTEGER;
+	case A5Type::UBIGINT:
+		return LogicalType::UBIGINT;
+	case A5Type::DOUBLE:
+		return LogicalType::DOUBLE;
+	case A5Type::BOOLEAN:
+		return LogicalType::BOOLEAN;
+	case A5Type::VARCHAR:
+		return LogicalType::VARCHAR;
+	case A5Type::BLOB:
+		return LogicalType::BLOB;
+	case A5Type::POINT:
+		return LogicalType::ARRAY(LogicalType::DOUBLE, 2);
+	case A5Type::CELL_RANGE:
+		return LogicalType::ARRAY(LogicalType::UBIGINT, 2);
+	case A5Type::CELL_LIST:
+		return LogicalType::LIST(LogicalType::UBIGINT);
+	case A5Type::RING:
+		return LogicalType::LIST(LogicalType::ARRAY(LogicalType::DOUBLE, 2));
+	default:
+		throw InternalException("Unsupported A5Type in function table");
+	}
+}
+
+// True when the first `count` rows of the selection refer to every one of the `dictionary_size` entries
+static bool A5ReferencesAllEntries(const SelectionVector &sel, idx_t count, idx_t dictionary_size) {
+	vector<bool> referenced(dictionary_size, false);
+	idx_t referenced_count = 0;
+	for (idx_t i = 0; i < count && referenced_count < dictionary_size; i++) {
+		auto entry = sel.get_index(i);
+		if (!referenced[entry]) {
+			referenced[entry] = true;
+			referenced_count++;
+		}
+	}
+	return referenced_count == dictionary_size;
+}
+
+// Many inputs reach the functions as constants or as dictionaries, for example after joins or from
+// dictionary-encoded Parquet columns. When every argument is constant the function runs for one row
+// and returns a constant; when one argument is a dictionary smaller than the chunk and the others are
+// constant, it runs once per dictionary entry and the result is a dictionary over those results.
+// TRY_ functions stay correct because NULL results are carried by the dictionary's validity.
+// A dictionary can hold entries no row refers to anymore, e.g. after a filter, and an error on such an
+// entry must not fail the query, so the dictionary is only used when the rows refer to all of its entries.
+static void A5ExecuteDistinct(a5_scalar_function_ptr_t function, DataChunk &args, ExpressionState &state,
+                              Vector &result) {
+	auto count = args.size();
+	if (args.ColumnCount() == 0 || count <= 1) {
+		function(args, state, result);
+		return;
+	}
+	optional_idx dictionary_column;
+	for (idx_t col = 0; col < args.ColumnCount(); col++) {
+		auto vector_type = args.data[col].GetVectorType();
+		if (vector_type == VectorType::CONSTANT_VECTOR) {
+			continue;
+		}
+		if (vector_type != VectorType::DICTIONARY_VECTOR || dictionary_column.IsValid()) {
+			// Rows differ in a way that is not shared between them
+			function(args, state, result);
+			return;
+		}
+		dictionary_column = col;
+	}
+
+	idx_t distinct_count = 1;
+	if (dictionary_column.IsValid()) {
+		auto dictionary_size = DictionaryVector::DictionarySize(args.data[dictionary_column.GetIndex()]);
+		if (!dictionary_size.IsValid() || dictionary_size.GetIndex() >= count) {
+			function(args, state, result);
+			return;
+		}
+		distinct_count = dictionary_size.GetIndex();
+		if (!A5ReferencesAllEntries(DictionaryVector::SelVector(args.data[dictionary_column.GetIndex()]), count,
+		                            distinct_count)) {
+			function(args, state, result);
+			return;
+		}
+	}
+
+	DataChunk distinct_args;
+	distinct_args.InitializeEmpty(args.GetTypes());
+	for (idx_t col = 0; col < args.ColumnCount(); col++) {
+		if (dictionary_column.IsValid() && col == dictionary_column.GetIndex()) {
+			distinct_args.data[col].Reference(DictionaryVector::Child(args.data[col]));
+		} else {
+			distinct_args.data[col].Reference(args.data[col]);
+		}
+	}
+	distinct_args.SetCardinality(distinct_count);
+
+	if (!dictionary_column.IsValid()) {
+		function(distinct_args, state, result);
+		result.SetVectorType(VectorType::CONSTANT_VECTOR);
+		return;
+	}
+	Vector distinct_result(result.GetType(), distinct_count);
+	function(distinct_args, state, distinct_result);
+	result.Slice(distinct_result, DictionaryVector::SelVector(args.data[dictionary_column.GetIndex()]), count);
+}
+
+void A5RegisterScalarFunctions(ExtensionLoader &loader, const A5ScalarFunctionEntry *entries, idx_t count) {
+	idx_t begin = 0;
+	while (begin < count) {
+		auto name = entries[begin].name;
+		idx_t end = begin + 1;
+		while (end < count && strcmp(entries[end].name, name) == 0) {
+			end++;
+		}
+
+		ScalarFunctionSet set(name);
+		vector<FunctionDescription> descriptions;
+		for (idx_t i = begin; i < end; i++) {
+			auto &entry = entries[i];
+			FunctionDescription desc;
+			vector<LogicalType> arguments;
+			for (idx_t arg = 0; arg < A5_MAX_FUNCTION_ARGUMENTS && entry.arguments[arg] != A5Type::NONE; arg++) {
+				arguments.push_back(A5GetLogicalType(entry.arguments[arg]));
+				desc.parameter_names.push_back(entry.parameter_names[arg]);
+			}
+			desc.parameter_types = arguments;
+			desc.description = entry.description;
+			desc.examples = {entry.example};
+			desc.categories = {"a5", "geospatial"};
+			descriptions.push_back(std::move(desc));
+
+			auto function = entry.function;
+			ScalarFunction func(name, std::move(arguments), A5GetLogicalType(entry.return_type),
+			                    [function](DataChunk &args, ExpressionState &state, Vector &result) {
+				                    A5ExecuteDistinct(function, args, state, result);
+			                    });
+			func.statistics = entry.statistics;
+			func.init_local_state = entry.init_local_state;
+			set.AddFunction(std::move(func));
+		}
+
+		CreateScalarFunctionInfo info(std::move(set));
+		info.descriptions = std::move(descriptions);
+		A5RegisterScalarFunction(loader, std::move(info));
+		begin = end;
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,509 @@
+#include "a5_common.hpp"
+#include "a5_lookup_table.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace duckdb {
+
+static constexpr const char *A5_LOOKUP_TABLE_SETTING = "a5_lookup_table";
+static constexpr const char *A5_LOOKUP_TABLE_ENV = "A5_LOOKUP_TABLE";
+
+static constexpr char A5_LOOKUP_MAGIC[8] = {'A', '5', 'L', 'O', 'O', 'K', 'U', 'P'};
+static constexpr uint32_t A5_LOOKUP_VERSION = 1;
+// Written in native order; a file from a machine of the other byte order reads as 0x04030201
+static constexpr uint32_t A5_LOOKUP_BYTE_ORDER = 0x01020304;
+
+struct A5LookupFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t max_resolution;
+	uint32_t reserved;
+};
+
+// File offsets are from the start of the file and aligned to 8 bytes
+struct A5LookupFileSection {
+	uint64_t cell_count;
+	uint64_t centroids;
+	uint64_t boundary_offsets;
+	uint64_t boundary_points;
+	uint64_t boundary_point_count;
+	uint64_t neighbour_offsets;
+	uint64_t neighbours;
+	uint64_t neighbour_count;
+};
+
+// Read-only view of a whole file: memory-mapped where the platform allows it, read into memory otherwise
+class A5MappedFile {
+public:
+	static unique_ptr<A5MappedFile> Open(const string &path) {
+		auto result = unique_ptr<A5MappedFile>(new A5MappedFile());
+#ifndef _WIN32
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw IOException("a5_lookup_table: cannot open \"%s\"", path);
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+			close(fd);
+			throw IOException("a5_lookup_table: cannot read \"%s\"", path);
+		}
+		auto mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (mapping == MAP_FAILED) {
+			throw IOException("a5_lookup_table: cannot map \"%s\"", path);
+		}
+		result->data = static_cast<const data_t *>(mapping);
+		result->size = static_cast<idx_t>(st.st_size);
+#else
+		auto fs = FileSystem::CreateLocal();
+		auto handle = fs->OpenFile(path, FileFlags::FILE_FLAGS_READ);
+		result->size = handle->GetFileSize();
+		result->buffer = make_unsafe_uniq_array<data_t>(result->size);
+		handle->Read(result->buffer.get(), result->size, 0);
+		result->data = result->buffer.get();
+#endif
+		return result;
+	}
+
+	~A5MappedFile() {
+#ifndef _WIN32
+		if (data) {
+			munmap(const_cast<data_t *>(data), size);
+		}
+#endif
+	}
+
+	const data_t *data = nullptr;
+	idx_t size = 0;
+
+private:
+	A5MappedFile() = default;
+#ifdef _WIN32
+	unsafe_unique_array<data_t> buffer;
+#endif
+};
+
+thread_local const A5LookupTable *A5LookupTable::thread_table = nullptr;
+
+A5LookupTable::~A5LookupTable() {
+}
+
+// Returns the array of `count` elements at `offset`, checking that it lies within the file
+template <class T>
+static const T *A5LookupArray(const A5MappedFile &file, uint64_t offset, uint64_t count, const string &path) {
+	if (offset % 8 != 0 || offset > file.size || count > (file.size - offset) / sizeof(T)) {
+		throw IOException("a5_lookup_table: \"%s\" is truncated or corrupt", path);
+	}
+	return reinterpret_cast<const T *>(file.data + offset);
+}
+
+// Offsets into a variable-length array must start at 0, never decrease and end at its length
+static void A5ValidateLookupOffsets(const uint32_t *offsets, uint64_t cell_count, uint64_t total, const string &path) {
+	if (offsets[0] != 0 || offsets[cell_count] != total) {
+		throw IOException("a5_lookup_table: \"%s\" is truncated or corrupt", path);
+	}
+	for (uint64_t i = 0; i < cell_count; i++) {
+		if (offsets[i] > offsets[i + 1]) {
+			throw IOException("a5_lookup_table: \"%s\" is truncated or corrupt", path);
+		}
+	}
+}
+
+unique_ptr<A5LookupTable> A5LookupTable::Load(const string &path) {
+	auto table = unique_ptr<A5LookupTable>(new A5LookupTable());
+	table->file = A5MappedFile::Open(path);
+	auto &file = *table->file;
+	auto header = A5LookupArray<A5LookupFileHeader>(file, 0, 1, path);
+	if (memcmp(header->magic, A5_LOOKUP_MAGIC, sizeof(A5_LOOKUP_MAGIC)) != 0) {
+		throw IOException("a5_lookup_table: \"%s\" is not an A5 lookup table", path);
+	}
+	if (header->version != A5_LOOKUP_VERSION || header->byte_order != A5_LOOKUP_BYTE_ORDER) {
+		throw IOException("a5_lookup_table: \"%s\" was written by another version or platform; regenerate it with "
+		                  "a5_write_lookup_table",
+		                  path);
+	}
+	if (header->max_resolution > A5_MAX_LOOKUP_RESOLUTION) {
+		throw IOException("a5_lookup_table: \"%s\" is truncated or corrupt", path);
+	}
+
+	auto file_sections =
+	    A5LookupArray<A5LookupFileSection>(file, sizeof(A5LookupFileHeader), header->max_resolution + 1, path);
+	for (int32_t resolution = 0; resolution <= static_cast<int32_t>(header->max_resolution); resolution++) {
+		auto &file_section = file_sections[resolution];
+		auto cell_count = a5_index::NumCells(resolution);
+		if (file_section.cell_count != cell_count) {
+			throw IOException("a5_lookup_table: \"%s\" is truncated or corrupt", path);
+		}
+		Section section;
+		section.resolution = resolution;
+		section.cell_count = cell_count;
+		section.centroids = A5LookupArray<LonLatDegrees>(file, file_section.centroids, cell_count, path);
+		section.boundary_offsets = A5LookupArray<uint32_t>(file, file_section.boundary_offsets, cell_count + 1, path);
+		section.boundary_points =
+		    A5LookupArray<LonLatDegrees>(file, file_section.boundary_points, file_section.boundary_point_count, path);
+		section.neighbour_offsets =
+		    A5LookupArray<uint32_t>(file, file_section.neighbour_offsets, cell_count + 1, path);
+		section.neighbours = A5LookupArray<uint32_t>(file, file_section.neighbours, file_section.neighbour_count, path);
+		A5ValidateLookupOffsets(section.boundary_offsets, cell_count, file_section.boundary_point_count, path);
+		A5ValidateLookupOffsets(section.neighbour_offsets, cell_count, file_section.neighbour_count, path);
+		for (uint64_t i = 0; i < file_section.neighbour_count; i++) {
+			if (section.neighbours[i] >= cell_count) {
+				throw IOException("a5_lookup_table: \"%s\" is truncated or corrupt", path);
+			}
+		}
+		table->sections.push_back(section);
+	}
+	return table;
+}
+
+// The lookup tables of one database, owned by its object cache so they are unmapped when it is closed
+class A5LookupTableEntry : public ObjectCacheEntry {
+public:
+	static string ObjectType() {
+		return "a5_lookup_table";
+	}
+
+	string GetObjectType() override {
+		return ObjectType();
+	}
+
+	// Not a cache: the entry must not be evicted while a table is loaded
+	optional_idx GetEstimatedCacheMemory() const override {
+		return optional_idx();
+	}
+
+	// Maps the file and makes it the current table; an empty path unloads the table
+	void Load(const string &path) {
+		lock_guard<mutex> guard(lock);
+		if (path.empty()) {
+			current.store(nullptr, std::memory_order_release);
+			return;
+		}
+		auto table = A5LookupTable::Load(path);
+		current.store(table.get(), std::memory_order_release);
+		loaded.push_back(std::move(table));
+	}
+
+	atomic<const A5LookupTable *> current {nullptr};
+
+private:
+	mutex lock;
+	// Replaced tables are kept, so a query holding a pointer from A5GetLookupTable can keep using it
+	vector<unique_ptr<A5LookupTable>> loaded;
+};
+
+static shared_ptr<A5LookupTableEntry> A5GetLookupTableEntry(DatabaseInstance &db) {
+	return db.GetObjectCache().GetOrCreate<A5LookupTableEntry>(A5LookupTableEntry::ObjectType());
+}
+
+const A5LookupTable *A5GetLookupTable(ClientContext &context) {
+	return A5GetLookupTableEntry(*context.db)->current.load(std::memory_order_acquire);
+}
+
+scalar_function_t A5LookupTableFunction(DatabaseInstance &db, scalar_function_t function) {
+	auto entry = A5GetLookupTableEntry(db);
+	return [entry, function](DataChunk &args, ExpressionState &state, Vector &result) {
+		A5LookupTableScope scope(entry->current.load(std::memory_order_acquire));
+		function(args, state, result);
+	};
+}
+
+int32_t A5GridDiskInto(uint64_t cell, uintptr_t k, CellSink sink, void *ctx) {
+	auto table = A5LookupTable::Get();
+	// Wider disks would come out of a ring expansion in another order than Rust's, so they are left to it
+	auto count = table && k == 1 ? table->NeighbourCount(cell) : 0;
+	if (count == 0) {
+		return a5_grid_disk_into(cell, k, sink, ctx);
+	}
+	auto out = sink(ctx, count);
+	if (!out) {
+		return A5_ERROR_ALLOCATION;
+	}
+	table->ForEachNeighbour(cell, [&](uint64_t neighbour) { *out++ = neighbour; });
+	return A5_OK;
+}
+
+// Writes a lookup table front to back. Arrays whose length is only known after the cells have been
+// visited get their space reserved and are filled in afterwards. The file is written next to its path and
+// renamed over it when complete, so a table another database has mapped from that path is never
+// truncated under it.
+class A5LookupTableWriter {
+public:
+	A5LookupTableWriter(FileSystem &fs, const string &path)
+	    : fs(fs), path(path), temporary_path(path + ".tmp"),
+	      handle(fs.OpenFile(temporary_path, FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW)),
+	      position(0), written(0) {
+	}
+
+	~A5LookupTableWriter() {
+		if (handle) {
+			// Not finished: an error is propagating, so only try to clean up
+			try {
+				handle->Close();
+				fs.RemoveFile(temporary_path);
+			} catch (...) {
+			}
+		}
+	}
+
+	uint64_t Reserve(idx_t bytes) {
+		auto location = position;
+		position = AlignValue<uint64_t, 8>(position + bytes);
+		return location;
+	}
+
+	void WriteAt(uint64_t location, const void *data, idx_t bytes) {
+		if (bytes > 0) {
+			handle->Write(const_cast<void *>(data), bytes, location);
+			written = MaxValue<uint64_t>(written, location + bytes);
+		}
+	}
+
+	// Pads the file to the reserved end, flushes it and moves it to its path
+	void Finish() {
+		static const uint64_t zero = 0;
+		WriteAt(written, &zero, position - written);
+		handle->Sync();
+		handle->Close();
+		handle.reset();
+		fs.MoveFile(temporary_path, path);
+	}
+
+	uint64_t Position() const {
+		return position;
+	}
+
+private:
+	FileSystem &fs;
+	string path;
+	string temporary_path;
+	unique_ptr<FileHandle> handle;
+	uint64_t position;
+	// End of the furthest write so far
+	uint64_t written;
+};
+
+// Cells of one resolution visited per batch while writing
+static constexpr idx_t A5_LOOKUP_WRITE_BATCH = STANDARD_VECTOR_SIZE;
+
+static uint64_t A5WriteLookupSection(A5LookupTableWriter &writer, int32_t resolution, A5LookupFileSection &section) {
+	auto start = writer.Position();
+	auto cell_count = a5_index::NumCells(resolution);
+	section.cell_count = cell_count;
+
+	// Centroids, converted a batch at a time like a5_cell_to_lonlat
+	section.centroids = writer.Reserve(cell_count * sizeof(LonLatDegrees));
+	uint64_t cells[A5_LOOKUP_WRITE_BATCH];
+	double centroids[A5_LOOKUP_WRITE_BATCH * 2];
+	uint64_t validity[(A5_LOOKUP_WRITE_BATCH + 63) / 64];
+	for (uint64_t first = 0; first < cell_count; first += A5_LOOKUP_WRITE_BATCH) {
+		auto count = MinValue<uint64_t>(A5_LOOKUP_WRITE_BATCH, cell_count - first);
+		for (idx_t i = 0; i < count; i++) {
+			cells[i] = a5_index::OffsetToCell(first + i, resolution);
+		}
+		memset(validity, 0xFF, sizeof(validity));
+		if (a5_cell_to_lon_lat_batch(cells, centroids, validity, count) > 0) {
+			throw InvalidInputException("a5_write_lookup_table: failed to compute the centroids of resolution %d",
+			                            resolution);
+		}
+		writer.WriteAt(section.centroids + first * sizeof(LonLatDegrees), centroids, count * sizeof(LonLatDegrees));
+	}
+
+	// Boundaries and neighbours: the offsets are written once all cells have been visited
+	vector<uint32_t> boundary_offsets {0};
+	vector<uint32_t> neighbour_offsets {0};
+	boundary_offsets.reserve(cell_count + 1);
+	neighbour_offsets.reserve(cell_count + 1);
+	section.boundary_offsets = writer.Reserve((cell_count + 1) * sizeof(uint32_t));
+	section.neighbour_offsets = writer.Reserve((cell_count + 1) * sizeof(uint32_t));
+
+	vector<LonLatDegrees> points;
+	uint64_t point_count = 0;
+	section.boundary_points = writer.Position();
+	CellBoundaryOptions options;
+	options.closed_ring = true;
+	options.segments = -1;
+	for (uint64_t first = 0; first < cell_count; first += A5_LOOKUP_WRITE_BATCH) {
+		auto count = MinValue<uint64_t>(A5_LOOKUP_WRITE_BATCH, cell_count - first);
+		points.clear();
+		for (idx_t i = 0; i < count; i++) {
+			auto cell = a5_index::OffsetToCell(first + i, resolution);
+			ThrowRustError(a5_cell_to_boundary_into(cell, options, A5VectorSink<LonLatDegrees>, &points),
+			               "a5_write_lookup_table");
+			boundary_offsets.push_back(NumericCast<uint32_t>(point_count + points.size()));
+		}
+		// Batches are written back to back, so the points stay one contiguous array
+		writer.WriteAt(section.boundary_points + point_count * sizeof(LonLatDegrees), points.data(),
+		               points.size() * sizeof(LonLatDegrees));
+		point_count += points.size();
+	}
+	section.boundary_point_count = point_count;
+	writer.Reserve(point_count * sizeof(LonLatDegrees));
+
+	vector<uint64_t> disk;
+	vector<uint32_t> neighbours;
+	uint64_t neighbour_count = 0;
+	section.neighbours = writer.Position();
+	for (uint64_t first = 0; first < cell_count; first += A5_LOOKUP_WRITE_BATCH) {
+		auto count = MinValue<uint64_t>(A5_LOOKUP_WRITE_BATCH, cell_count - first);
+		neighbours.clear();
+		for (idx_t i = 0; i < count; i++) {
+			auto cell = a5_index::OffsetToCell(first + i, resolution);
+			disk.clear();
+			ThrowRustError(a5_grid_disk_into(cell, 1, A5VectorSink<uint64_t>, &disk), "a5_write_lookup_table");
+			for (auto neighbour : disk) {
+				int32_t neighbour_resolution;
+				uint64_t offset;
+				if (!a5_index::CellToOffset(neighbour, neighbour_resolution, offset) ||
+				    neighbour_resolution != resolution) {
+					throw InvalidInputException("a5_write_lookup_table: unexpected neighbour %llu of cell %llu",
+					                            neighbour, cell);
+				}
+				neighbours.push_back(NumericCast<uint32_t>(offset));
+			}
+			neighbour_offsets.push_back(NumericCast<uint32_t>(neighbour_count + neighbours.size()));
+		}
+		writer.WriteAt(section.neighbours + neighbour_count * sizeof(uint32_t), neighbours.data(),
+		               neighbours.size() * sizeof(uint32_t));
+		neighbour_count += neighbours.size();
+	}
+	section.neighbour_count = neighbour_count;
+	writer.Reserve(neighbour_count * sizeof(uint32_t));
+
+	writer.WriteAt(section.boundary_offsets, boundary_offsets.data(), boundary_offsets.size() * sizeof(uint32_t));
+	writer.WriteAt(section.neighbour_offsets, neighbour_offsets.data(), neighbour_offsets.size() * sizeof(uint32_t));
+	return writer.Position() - start;
+}
+
+struct A5WriteLookupTableBindData : public TableFunctionData {
+	string path;
+	int32_t max_resolution;
+};
+
+struct A5WriteLookupTableState : public GlobalTableFunctionState {
+	bool finished = false;
+};
+
+static unique_ptr<FunctionData> A5WriteLookupTableBind(ClientContext &context, TableFunctionBindInput &input,
+                                                       vector<LogicalType> &return_types, vector<string> &names) {
+	if (input.inputs[0].IsNull() || input.inputs[1].IsNull()) {
+		throw InvalidInputException("a5_write_lookup_table: path and max_resolution must not be NULL");
+	}
+	auto result = make_uniq<A5WriteLookupTableBindData>();
+	result->path = StringValue::Get(input.inputs[0]);
+	result->max_resolution = input.inputs[1].GetValue<int32_t>();
+	if (result->max_resolution < 0 || result->max_resolution > A5_MAX_LOOKUP_RESOLUTION) {
+		throw InvalidInputException("a5_write_lookup_table: max_resolution must be between 0 and %d",
+		                            A5_MAX_LOOKUP_RESOLUTION);
+	}
+	names.emplace_back("resolution");
+	return_types.emplace_back(LogicalType::INTEGER);
+	names.emplace_back("cells");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("bytes");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	return std::move(result);
+}
+
+static unique_ptr<GlobalTableFunctionState> A5WriteLookupTableInit(ClientContext &context,
+                                                                   TableFunctionInitInput &input) {
+	return make_uniq<A5WriteLookupTableState>();
+}
+
+// Writes the whole file on the first call and returns one row per resolution
+static void A5WriteLookupTableFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &bind_data = data.bind_data->Cast<A5WriteLookupTableBindData>();
+	auto &state = data.global_state->Cast<A5WriteLookupTableState>();
+	if (state.finished) {
+		return;
+	}
+	state.finished = true;
+
+	auto section_count = static_cast<idx_t>(bind_data.max_resolution + 1);
+	A5LookupTableWriter writer(FileSystem::GetFileSystem(context), bind_data.path);
+	auto header_location = writer.Reserve(sizeof(A5LookupFileHeader) + section_count * sizeof(A5LookupFileSection));
+
+	vector<A5LookupFileSection> sections(section_count);
+	for (idx_t resolution = 0; resolution < section_count; resolution++) {
+		auto bytes = A5WriteLookupSection(writer, static_cast<int32_t>(resolution), sections[resolution]);
+		output.SetValue(0, resolution, Value::INTEGER(static_cast<int32_t>(resolution)));
+		output.SetValue(1, resolution, Value::UBIGINT(sections[resolution].cell_count));
+		output.SetValue(2, resolution, Value::UBIGINT(bytes));
+	}
+
+	A5LookupFileHeader header;
+	memcpy(header.magic, A5_LOOKUP_MAGIC, sizeof(A5_LOOKUP_MAGIC));
+	header.version = A5_LOOKUP_VERSION;
+	header.byte_order = A5_LOOKUP_BYTE_ORDER;
+	header.max_resolution = static_cast<uint32_t>(bind_data.max_resolution);
+	header.reserved = 0;
+	writer.WriteAt(header_location, &header, sizeof(header));
+	writer.WriteAt(header_location + sizeof(header), sections.data(), section_count * sizeof(A5LookupFileSection));
+	writer.Finish();
+	output.SetCardinality(section_count);
+}
+
+// The table is mapped with the platform's own calls, bypassing the database's file system, so its access
+// rules (enable_external_access, allowed_directories, allowed_paths) are applied to the path first
+static void A5CheckLookupTableAccess(DatabaseInstance &db, const string &path) {
+	if (!path.empty() && !DBConfig::GetConfig(db).CanAccessFile(path, FileType::FILE_TYPE_REGULAR)) {
+		throw PermissionException("a5_lookup_table: cannot load \"%s\" because external file access is disabled",
+		                          path);
+	}
+}
+
+static void A5SetLookupTable(ClientContext &context, SetScope scope, Value &parameter) {
+	auto path = parameter.IsNull() ? string() : StringValue::Get(parameter);
+	A5CheckLookupTableAccess(*context.db, path);
+	if (!path.empty()) {
+		// Opening through the client's file system also runs the checks of its opener
+		FileSystem::GetFileSystem(context).OpenFile(path, FileFlags::FILE_FLAGS_READ);
+	}
+	A5GetLookupTableEntry(*context.db)->Load(path);
+}
+
+void RegisterA5LookupTable(ExtensionLoader &loader) {
+	auto &config = DBConfig::GetConfig(loader.GetDatabaseInstance());
+	config.AddExtensionOption(A5_LOOKUP_TABLE_SETTING,
+	                          "Path of a file written by a5_write_lookup_table to serve coarse cell centroids, "
+	                          "boundaries and neighbours from; applies to every connection of the database, '' unloads",
+	                          LogicalType::VARCHAR, Value(""), A5SetLookupTable);
+
+	auto env_path = std::getenv(A5_LOOKUP_TABLE_ENV);
+	if (env_path && *env_path) {
+		A5CheckLookupTableAccess(loader.GetDatabaseInstance(), env_path);
+		A5GetLookupTableEntry(loader.GetDatabaseInstance())->Load(env_path);
+	}
+
+	// a5_write_lookup_table: Precomputes the geometry of every cell up to a coarse resolution
+	{
+		TableFunction func("a5_write_lookup_table", {LogicalType::VARCHAR, LogicalType::INTEGER},
+		                   A5WriteLookupTableFunction, A5WriteLookupTableBind, A5WriteLookupTableInit);
+		CreateTableFunctionInfo info(func);
+		FunctionDescription desc;
+		desc.description = "Writes the centroids, boundaries and neighbours of every A5 cell up to max_resolution "
+		                   "(at most 8) to a file for the a5_lookup_table setting, and returns the cells and bytes "
+		                   "per resolution";
+		desc.parameter_names = {"path", "max_resolution"};
+		desc.parameter_types = {LogicalType::VARCHAR, LogicalType::INTEGER};
+		desc.examples = {"SELECT * FROM a5_write_lookup_table('a5_lookup.bin', 6)"};
+		desc.categories = {"a5", "geospatial"};
+		info.descriptions.push_back(std::move(desc));
+		A5RegisterTableFunction(loader, std::move(info));
+	}
+}
+
+} // namespace duckdb
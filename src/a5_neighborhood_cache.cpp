@@ -0,0 +1,109 @@
+#include "a5_common.hpp"
+#include "a5_neighborhood_cache.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+
+namespace duckdb {
+
+static constexpr const char *A5_NEIGHBORHOOD_CACHE_SIZE_SETTING = "a5_neighborhood_cache_size";
+
+// Entries kept per thread and function when the setting is not changed
+static constexpr int64_t A5_DEFAULT_NEIGHBORHOOD_CACHE_SIZE = 4096;
+
+static const char *A5NeighborhoodFunctionName(idx_t function) {
+	switch (static_cast<A5NeighborhoodFunction>(function)) {
+	case A5NeighborhoodFunction::SPHERICAL_CAP:
+		return "a5_spherical_cap";
+	case A5NeighborhoodFunction::GRID_DISK:
+		return "a5_grid_disk";
+	case A5NeighborhoodFunction::GRID_RING:
+		return "a5_grid_ring";
+	default:
+		return "a5_grid_disk_vertex";
+	}
+}
+
+struct A5NeighborhoodCacheCounters {
+	atomic<uint64_t> hits {0};
+	atomic<uint64_t> misses {0};
+};
+
+static A5NeighborhoodCacheCounters a5_neighborhood_counters[A5_NEIGHBORHOOD_FUNCTION_COUNT];
+
+void A5RecordNeighborhoodCacheStats(A5NeighborhoodFunction function, idx_t hits, idx_t misses) {
+	auto &counters = a5_neighborhood_counters[static_cast<idx_t>(function)];
+	if (hits > 0) {
+		counters.hits.fetch_add(hits, std::memory_order_relaxed);
+	}
+	if (misses > 0) {
+		counters.misses.fetch_add(misses, std::memory_order_relaxed);
+	}
+}
+
+unique_ptr<FunctionLocalState> A5NeighborhoodInitLocalState(ExpressionState &state, const BoundFunctionExpression &expr,
+                                                            FunctionData *bind_data) {
+	int64_t capacity = A5_DEFAULT_NEIGHBORHOOD_CACHE_SIZE;
+	Value setting;
+	if (state.GetContext().TryGetCurrentSetting(A5_NEIGHBORHOOD_CACHE_SIZE_SETTING, setting) && !setting.IsNull()) {
+		capacity = setting.GetValue<int64_t>();
+	}
+	return make_uniq<A5NeighborhoodLocalState>(static_cast<idx_t>(MaxValue<int64_t>(capacity, 0)));
+}
+
+struct A5NeighborhoodCacheStatsState : public GlobalTableFunctionState {
+	idx_t next_function = 0;
+};
+
+static unique_ptr<FunctionData> A5NeighborhoodCacheStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                             vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("function_name");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("hits");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("misses");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> A5NeighborhoodCacheStatsInit(ClientContext &context,
+                                                                         TableFunctionInitInput &input) {
+	return make_uniq<A5NeighborhoodCacheStatsState>();
+}
+
+static void A5NeighborhoodCacheStatsFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = data.global_state->Cast<A5NeighborhoodCacheStatsState>();
+	idx_t count = 0;
+	for (; state.next_function < A5_NEIGHBORHOOD_FUNCTION_COUNT; state.next_function++) {
+		auto &counters = a5_neighborhood_counters[state.next_function];
+		output.SetValue(0, count, Value(A5NeighborhoodFunctionName(state.next_function)));
+		output.SetValue(1, count, Value::UBIGINT(counters.hits.load(std::memory_order_relaxed)));
+		output.SetValue(2, count, Value::UBIGINT(counters.misses.load(std::memory_order_relaxed)));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+void RegisterA5NeighborhoodCache(ExtensionLoader &loader) {
+	auto &config = DBConfig::GetConfig(loader.GetDatabaseInstance());
+	config.AddExtensionOption(A5_NEIGHBORHOOD_CACHE_SIZE_SETTING,
+	                          "Number of results a5_grid_disk, a5_grid_disk_vertex, a5_grid_ring and a5_spherical_cap "
+	                          "keep per thread for repeated (cell, k) or (cell, radius) arguments; 0 disables the cache",
+	                          LogicalType::BIGINT, Value::BIGINT(A5_DEFAULT_NEIGHBORHOOD_CACHE_SIZE));
+
+	// a5_neighborhood_cache_stats: Reports the neighborhood cache hit and miss counters
+	{
+		TableFunction func("a5_neighborhood_cache_stats", {}, A5NeighborhoodCacheStatsFunction,
+		                   A5NeighborhoodCacheStatsBind, A5NeighborhoodCacheStatsInit);
+		CreateTableFunctionInfo info(func);
+		FunctionDescription desc;
+		desc.description = "Returns the number of cache hits and misses of the neighborhood functions since the "
+		                   "extension was loaded";
+		desc.examples = {"SELECT * FROM a5_neighborhood_cache_stats()"};
+		desc.categories = {"a5", "geospatial"};
+		info.descriptions.push_back(std::move(desc));
+		A5RegisterTableFunction(loader, std::move(info));
+	}
+}
+
+} // namespace duckdb
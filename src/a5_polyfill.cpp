@@ -0,0 +1,472 @@
+#include "a5_arena.hpp"
+#include "a5_cell_set.hpp"
+#include "a5_common.hpp"
+#include "a5_function_table.hpp"
+#include "a5_lookup_table.hpp"
+#include "duckdb/common/bswap.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/parser/parsed_data/create_scalar_function_info.hpp"
+
+namespace duckdb {
+
+// Which cells at the target resolution that straddle the polygon boundary are kept
+enum class A5PolyfillMode : uint8_t {
+	// The cell's center lies inside the polygon
+	CENTER,
+	// Any part of the cell overlaps the polygon
+	INTERSECTS,
+	// The whole cell lies inside the polygon
+	CONTAINS
+};
+
+static A5PolyfillMode A5ParsePolyfillMode(const string_t &mode) {
+	auto name = StringUtil::Lower(mode.GetString());
+	if (name == "center") {
+		return A5PolyfillMode::CENTER;
+	}
+	if (name == "intersects") {
+		return A5PolyfillMode::INTERSECTS;
+	}
+	if (name == "contains") {
+		return A5PolyfillMode::CONTAINS;
+	}
+	throw InvalidInputException("a5_polygon_to_cells: mode must be one of 'center', 'intersects' or 'contains'");
+}
+
+// Relation of a cell to the polygon. UNKNOWN is used for cells whose boundary cannot be treated as a
+// planar lon/lat ring (they wrap around the antimeridian or a pole); they are refined unless their
+// latitudes rule out the polygon.
+enum class A5CellRelation : uint8_t { OUTSIDE, INSIDE, BOUNDARY, UNKNOWN };
+
+struct A5BoundingBox {
+	double min_x = NumericLimits<double>::Maximum();
+	double min_y = NumericLimits<double>::Maximum();
+	double max_x = NumericLimits<double>::Minimum();
+	double max_y = NumericLimits<double>::Minimum();
+
+	void Extend(double x, double y) {
+		min_x = MinValue(min_x, x);
+		min_y = MinValue(min_y, y);
+		max_x = MaxValue(max_x, x);
+		max_y = MaxValue(max_y, y);
+	}
+
+	bool Intersects(const A5BoundingBox &other) const {
+		return min_x <= other.max_x && other.min_x <= max_x && min_y <= other.max_y && other.min_y <= max_y;
+	}
+};
+
+// Points of a ring, allocated from the chunk arena
+struct A5Ring {
+	LonLatDegrees *points;
+	idx_t count;
+
+	idx_t size() const {
+		return count;
+	}
+
+	const LonLatDegrees &operator[](idx_t index) const {
+		return points[index];
+	}
+
+	const LonLatDegrees *begin() const {
+		return points;
+	}
+
+	const LonLatDegrees *end() const {
+		return points + count;
+	}
+};
+
+// Polygon with holes in planar lon/lat; rings are closed (first point repeated at the end)
+struct A5Polygon {
+	explicit A5Polygon(ArenaAllocator &arena) : arena(arena), rings(arena) {
+	}
+
+	ArenaAllocator &arena;
+	A5ArenaBuffer<A5Ring> rings;
+	A5BoundingBox bounds;
+
+	// Storage for a ring of `count` points, with room for the point AddRing may append to close it
+	LonLatDegrees *AllocateRing(idx_t count) {
+		return A5ArenaAllocate<LonLatDegrees>(arena, count + 1);
+	}
+
+	void AddRing(LonLatDegrees *points, idx_t count) {
+		if (count < 3) {
+			return;
+		}
+		if (points[0].lon != points[count - 1].lon || points[0].lat != points[count - 1].lat) {
+			points[count++] = points[0];
+		}
+		for (idx_t i = 0; i < count; i++) {
+			bounds.Extend(points[i].lon, points[i].lat);
+		}
+		rings.PushBack(A5Ring {points, count});
+	}
+
+	// Even-odd rule, so holes and the parts of a multipolygon need no special handling
+	bool Contains(double x, double y) const {
+		bool inside = false;
+		for (auto &ring : rings) {
+			for (idx_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+				auto &a = ring[i];
+				auto &b = ring[j];
+				if ((a.lat > y) != (b.lat > y) && x < (b.lon - a.lon) * (y - a.lat) / (b.lat - a.lat) + a.lon) {
+					inside = !inside;
+				}
+			}
+		}
+		return inside;
+	}
+};
+
+static double A5Orientation(const LonLatDegrees &a, const LonLatDegrees &b, const LonLatDegrees &c) {
+	return (b.lon - a.lon) * (c.lat - a.lat) - (b.lat - a.lat) * (c.lon - a.lon);
+}
+
+static bool A5OnSegment(const LonLatDegrees &a, const LonLatDegrees &b, const LonLatDegrees &p) {
+	return MinValue(a.lon, b.lon) <= p.lon && p.lon <= MaxValue(a.lon, b.lon) && MinValue(a.lat, b.lat) <= p.lat &&
+	       p.lat <= MaxValue(a.lat, b.lat);
+}
+
+static bool A5SegmentsIntersect(const LonLatDegrees &p1, const LonLatDegrees &p2, const LonLatDegrees &q1,
+                                const LonLatDegrees &q2) {
+	auto d1 = A5Orientation(q1, q2, p1);
+	auto d2 = A5Orientation(q1, q2, p2);
+	auto d3 = A5Orientation(p1, p2, q1);
+	auto d4 = A5Orientation(p1, p2, q2);
+	if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+		return true;
+	}
+	return (d1 == 0 && A5OnSegment(q1, q2, p1)) || (d2 == 0 && A5OnSegment(q1, q2, p2)) ||
+	       (d3 == 0 && A5OnSegment(p1, p2, q1)) || (d4 == 0 && A5OnSegment(p1, p2, q2));
+}
+
+// Scratch buffers of a5_polygon_to_cells, shared by the rows of a chunk
+struct A5PolyfillScratch {
+	explicit A5PolyfillScratch(ArenaAllocator &arena) : stack(arena), ring(arena) {
+	}
+
+	// Cells that still have to be classified
+	A5ArenaBuffer<uint64_t> stack;
+	// Boundary of the cell being classified
+	A5ArenaBuffer<LonLatDegrees> ring;
+};
+
+class A5Polyfill {
+public:
+	A5Polyfill(const A5Polygon &polygon, int32_t target_resolution, A5PolyfillMode mode, A5PolyfillScratch &scratch)
+	    : polygon(polygon), target_resolution(target_resolution), mode(mode), stack(scratch.stack),
+	      ring(scratch.ring) {
+	}
+
+	// Walks the hierarchy from the resolution 0 cells, refining only cells that cross the polygon
+	// boundary, and returns the compacted coverage
+	vector<uint64_t> Run() {
+		vector<uint64_t> result;
+		if (polygon.rings.empty()) {
+			return result;
+		}
+		stack.Clear();
+		for (auto cell : A5Res0Cells()) {
+			stack.PushBack(cell);
+		}
+		while (!stack.empty()) {
+			auto cell = stack.PopBack();
+			auto resolution = a5_get_resolution(cell);
+			auto relation = Classify(cell);
+			if (relation == A5CellRelation::OUTSIDE) {
+				continue;
+			}
+			if (relation == A5CellRelation::INSIDE) {
+				result.push_back(cell);
+				continue;
+			}
+			if (resolution < target_resolution) {
+				ThrowRustError(a5_cell_to_children_into(cell, resolution + 1, A5ArenaSink<uint64_t>, &stack),
+				               "a5_polygon_to_cells");
+				continue;
+			}
+			if (KeepBoundaryCell(cell, relation)) {
+				result.push_back(cell);
+			}
+		}
+		A5CompactCellSet(result, "a5_polygon_to_cells");
+		return result;
+	}
+
+private:
+	A5CellRelation Classify(uint64_t cell) {
+		ring.Clear();
+		CellBoundaryOptions options;
+		options.closed_ring = true;
+		options.segments = -1;
+		ThrowRustError(A5CellToBoundaryInto(cell, options, A5ArenaSink<LonLatDegrees>, &ring),
+		               "a5_polygon_to_cells");
+		if (ring.size() < 2) {
+			return A5CellRelation::UNKNOWN;
+		}
+
+		A5BoundingBox cell_bounds;
+		for (auto &point : ring) {
+			cell_bounds.Extend(point.lon, point.lat);
+		}
+		if (cell_bounds.max_x - cell_bounds.min_x > 180) {
+			// The longitudes are unusable, but the latitudes still bound the cell once a cell around a
+			// pole is extended to it: its ring stays in one hemisphere
+			if (cell_bounds.min_y > 0) {
+				cell_bounds.max_y = 90;
+			} else if (cell_bounds.max_y < 0) {
+				cell_bounds.min_y = -90;
+			}
+			if (cell_bounds.max_y < polygon.bounds.min_y || cell_bounds.min_y > polygon.bounds.max_y) {
+				return A5CellRelation::OUTSIDE;
+			}
+			return A5CellRelation::UNKNOWN;
+		}
+		if (!cell_bounds.Intersects(polygon.bounds)) {
+			return A5CellRelation::OUTSIDE;
+		}
+
+		for (auto &polygon_ring : polygon.rings) {
+			for (idx_t i = 0; i + 1 < polygon_ring.size(); i++) {
+				auto &q1 = polygon_ring[i];
+				auto &q2 = polygon_ring[i + 1];
+				if (MaxValue(q1.lon, q2.lon) < cell_bounds.min_x || MinValue(q1.lon, q2.lon) > cell_bounds.max_x ||
+				    MaxValue(q1.lat, q2.lat) < cell_bounds.min_y || MinValue(q1.lat, q2.lat) > cell_bounds.max_y) {
+					continue;
+				}
+				for (idx_t j = 0; j + 1 < ring.size(); j++) {
+					if (A5SegmentsIntersect(ring[j], ring[j + 1], q1, q2)) {
+						return A5CellRelation::BOUNDARY;
+					}
+				}
+			}
+		}
+
+		// No edges cross, so every ring lies wholly inside or wholly outside the cell. A ring inside it (a
+		// hole, or another part of a multipolygon) leaves it on the boundary; otherwise the cell is
+		// inside the polygon or disjoint from it.
+		for (auto &polygon_ring : polygon.rings) {
+			if (RingContains(polygon_ring[0].lon, polygon_ring[0].lat)) {
+				return A5CellRelation::BOUNDARY;
+			}
+		}
+		if (polygon.Contains(ring[0].lon, ring[0].lat)) {
+			return A5CellRelation::INSIDE;
+		}
+		return A5CellRelation::OUTSIDE;
+	}
+
+	bool RingContains(double x, double y) const {
+		bool inside = false;
+		for (idx_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+			auto &a = ring[i];
+			auto &b = ring[j];
+			if ((a.lat > y) != (b.lat > y) && x < (b.lon - a.lon) * (y - a.lat) / (b.lat - a.lat) + a.lon) {
+				inside = !inside;
+			}
+		}
+		return inside;
+	}
+
+	bool KeepBoundaryCell(uint64_t cell, A5CellRelation relation) {
+		if (mode == A5PolyfillMode::CONTAINS) {
+			return false;
+		}
+		if (mode == A5PolyfillMode::INTERSECTS && relation == A5CellRelation::BOUNDARY) {
+			return true;
+		}
+		auto center = a5_cell_to_lon_lat(cell);
+		ThrowRustError(center.error_code, "a5_polygon_to_cells");
+		return polygon.Contains(center.longitude, center.latitude);
+	}
+
+	const A5Polygon &polygon;
+	int32_t target_resolution;
+	A5PolyfillMode mode;
+	A5ArenaBuffer<uint64_t> &stack;
+	A5ArenaBuffer<LonLatDegrees> &ring;
+};
+
+// Reads WKB polygons and multipolygons (2D, either byte order)
+class A5WkbReader {
+public:
+	A5WkbReader(const string_t &blob) : data(const_data_ptr_cast(blob.GetData())), size(blob.GetSize()), pos(0) {
+	}
+
+	void ReadGeometry(A5Polygon &polygon) {
+		auto little_endian = ReadByteOrder();
+		auto type = ReadUInt32(little_endian);
+		if (type == 3) {
+			ReadPolygon(polygon, little_endian);
+		} else if (type == 6) {
+			auto count = ReadUInt32(little_endian);
+			for (uint32_t i = 0; i < count; i++) {
+				auto part_little_endian = ReadByteOrder();
+				if (ReadUInt32(part_little_endian) != 3) {
+					throw InvalidInputException("a5_polygon_to_cells: MULTIPOLYGON must contain only polygons");
+				}
+				ReadPolygon(polygon, part_little_endian);
+			}
+		} else {
+			throw InvalidInputException("a5_polygon_to_cells: WKB geometry must be a 2D POLYGON or MULTIPOLYGON");
+		}
+	}
+
+private:
+	void Require(idx_t bytes) {
+		if (pos + bytes > size) {
+			throw InvalidInputException("a5_polygon_to_cells: truncated WKB");
+		}
+	}
+
+	bool ReadByteOrder() {
+		Require(1);
+		return data[pos++] == 1;
+	}
+
+	uint32_t ReadUInt32(bool little_endian) {
+		Require(sizeof(uint32_t));
+		auto value = Load<uint32_t>(data + pos);
+		pos += sizeof(uint32_t);
+		return little_endian ? value : BSwap(value);
+	}
+
+	double ReadDouble(bool little_endian) {
+		Require(sizeof(double));
+		auto bits = Load<uint64_t>(data + pos);
+		pos += sizeof(double);
+		if (!little_endian) {
+			bits = BSwap(bits);
+		}
+		double value;
+		memcpy(&value, &bits, sizeof(double));
+		return value;
+	}
+
+	void ReadPolygon(A5Polygon &polygon, bool little_endian) {
+		auto ring_count = ReadUInt32(little_endian);
+		for (uint32_t r = 0; r < ring_count; r++) {
+			auto point_count = ReadUInt32(little_endian);
+			Require(idx_t(point_count) * 2 * sizeof(double));
+			auto ring = polygon.AllocateRing(point_count);
+			for (uint32_t p = 0; p < point_count; p++) {
+				ring[p].lon = ReadDouble(little_endian);
+				ring[p].lat = ReadDouble(little_endian);
+			}
+			polygon.AddRing(ring, point_count);
+		}
+	}
+
+	const_data_ptr_t data;
+	idx_t size;
+	idx_t pos;
+};
+
+template <class READ_POLYGON>
+static void A5PolygonToCellsExecute(DataChunk &args, ExpressionState &state, Vector &result,
+                                    READ_POLYGON &&read_polygon) {
+	auto count = args.size();
+	UnifiedVectorFormat geometry_format, resolution_format, mode_format;
+	args.data[0].ToUnifiedFormat(count, geometry_format);
+	args.data[1].ToUnifiedFormat(count, resolution_format);
+	auto has_mode = args.ColumnCount() == 3;
+	if (has_mode) {
+		args.data[2].ToUnifiedFormat(count, mode_format);
+	}
+	auto resolutions = UnifiedVectorFormat::GetData<int32_t>(resolution_format);
+
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto result_entries = FlatVector::GetData<list_entry_t>(result);
+	auto &result_validity = FlatVector::Validity(result);
+	idx_t result_size = 0;
+	// Polygons and traversal scratch live in the chunk arena, so rows do not allocate them separately
+	auto &arena = A5ChunkArena(state);
+	A5PolyfillScratch scratch(arena);
+
+	for (idx_t i = 0; i < count; i++) {
+		auto geometry_idx = geometry_format.sel->get_index(i);
+		auto resolution_idx = resolution_format.sel->get_index(i);
+		idx_t mode_idx = 0;
+		if (has_mode) {
+			mode_idx = mode_format.sel->get_index(i);
+		}
+		if (!geometry_format.validity.RowIsValid(geometry_idx) ||
+		    !resolution_format.validity.RowIsValid(resolution_idx) ||
+		    (has_mode && !mode_format.validity.RowIsValid(mode_idx))) {
+			result_validity.SetInvalid(i);
+			continue;
+		}
+		auto resolution = resolutions[resolution_idx];
+		ValidateResolution(resolution, "a5_polygon_to_cells");
+		auto mode = has_mode ? A5ParsePolyfillMode(UnifiedVectorFormat::GetData<string_t>(mode_format)[mode_idx])
+		                     : A5PolyfillMode::CENTER;
+
+		A5Polygon polygon(arena);
+		read_polygon(geometry_format, geometry_idx, polygon);
+		auto cells = A5Polyfill(polygon, resolution, mode, scratch).Run();
+
+		ListVector::Reserve(result, result_size + cells.size());
+		auto child_data = FlatVector::GetData<uint64_t>(ListVector::GetEntry(result));
+		memcpy(child_data + result_size, cells.data(), cells.size() * sizeof(uint64_t));
+		result_entries[i] = list_entry_t {result_size, cells.size()};
+		result_size += cells.size();
+		ListVector::SetListSize(result, result_size);
+	}
+
+	if (args.AllConstant()) {
+		result.SetVectorType(VectorType::CONSTANT_VECTOR);
+	}
+}
+
+static void A5RingToCellsFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &ring_vector = args.data[0];
+	auto &coordinates = ArrayVector::GetEntry(ListVector::GetEntry(ring_vector));
+	auto coordinate_data = FlatVector::GetData<double>(coordinates);
+
+	A5PolygonToCellsExecute(args, state, result, [&](UnifiedVectorFormat &format, idx_t idx, A5Polygon &polygon) {
+		auto entry = UnifiedVectorFormat::GetData<list_entry_t>(format)[idx];
+		auto ring = polygon.AllocateRing(entry.length);
+		for (idx_t p = 0; p < entry.length; p++) {
+			ring[p].lon = coordinate_data[(entry.offset + p) * 2];
+			ring[p].lat = coordinate_data[(entry.offset + p) * 2 + 1];
+		}
+		polygon.AddRing(ring, entry.length);
+	});
+}
+
+static void A5WkbToCellsFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	A5PolygonToCellsExecute(args, state, result, [&](UnifiedVectorFormat &format, idx_t idx, A5Polygon &polygon) {
+		A5WkbReader(UnifiedVectorFormat::GetData<string_t>(format)[idx]).ReadGeometry(polygon);
+	});
+}
+
+static const A5ScalarFunctionEntry A5_POLYFILL_FUNCTIONS[] = {
+    {"a5_polygon_to_cells", {A5Type::RING, A5Type::INTEGER}, A5Type::CELL_LIST, A5RingToCellsFun,
+     "Returns the compacted set of A5 cells whose centers lie inside the polygon ring of [lon, lat] points",
+     {"ring", "resolution"}, "a5_polygon_to_cells(a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 6)), 9)", nullptr,
+     A5ArenaInitLocalState},
+    {"a5_polygon_to_cells", {A5Type::RING, A5Type::INTEGER, A5Type::VARCHAR}, A5Type::CELL_LIST, A5RingToCellsFun,
+     "Returns the compacted set of A5 cells covering the polygon ring, where mode selects 'center' containment, "
+     "'intersects' or fully 'contains' semantics for boundary cells",
+     {"ring", "resolution", "mode"},
+     "a5_polygon_to_cells(a5_cell_to_boundary(a5_lonlat_to_cell(-122.4, 37.8, 6)), 9, 'intersects')", nullptr,
+     A5ArenaInitLocalState},
+    {"a5_polygon_to_cells", {A5Type::BLOB, A5Type::INTEGER}, A5Type::CELL_LIST, A5WkbToCellsFun,
+     "Returns the compacted set of A5 cells whose centers lie inside the WKB polygon or multipolygon",
+     {"wkb", "resolution"}, "a5_polygon_to_cells(ST_AsWKB(geom), 9)", nullptr, A5ArenaInitLocalState},
+    {"a5_polygon_to_cells", {A5Type::BLOB, A5Type::INTEGER, A5Type::VARCHAR}, A5Type::CELL_LIST, A5WkbToCellsFun,
+     "Returns the compacted set of A5 cells covering the WKB polygon or multipolygon, where mode selects 'center' "
+     "containment, 'intersects' or fully 'contains' semantics",
+     {"wkb", "resolution", "mode"}, "a5_polygon_to_cells(ST_AsWKB(geom), 9, 'contains')", nullptr,
+     A5ArenaInitLocalState},
+};
+
+void RegisterA5PolyfillFunctions(ExtensionLoader &loader) {
+	A5RegisterScalarFunctions(loader, A5_POLYFILL_FUNCTIONS);
+}
+
+} // namespace duckdb
@@ -0,0 +1,287 @@
+#include "a5_common.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/parser/parsed_data/create_scalar_function_info.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace duckdb {
+
+static constexpr const char *A5_PROFILING_SETTING = "a5_profiling";
+
+// Upper bound on the number of scalar functions that can be registered, each with its own counters
+static constexpr idx_t A5_MAX_PROFILED_FUNCTIONS = 128;
+
+enum class A5ProfileCounter : uint8_t { CALLS = 0, ROWS = 1, ELEMENTS = 2, ERRORS = 3, NANOS = 4 };
+
+static constexpr idx_t A5_PROFILE_COUNTER_COUNT = 5;
+
+// Read on every chunk of every profiled function, so it is a plain flag rather than a setting lookup
+static atomic<bool> a5_profiling_enabled {false};
+
+// Counters of one function on one thread. Only the owning thread writes them, with a relaxed load and
+// store instead of a read-modify-write, and each function has its own cache line, so the hot path never
+// contends with other threads. a5_profile() sums them across threads.
+struct alignas(64) A5FunctionCounters {
+	atomic<uint64_t> values[A5_PROFILE_COUNTER_COUNT];
+
+	void Add(A5ProfileCounter counter, uint64_t amount) {
+		auto &value = values[static_cast<idx_t>(counter)];
+		value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+
+	uint64_t Get(idx_t counter) const {
+		return values[counter].load(std::memory_order_relaxed);
+	}
+};
+
+struct A5ThreadProfile;
+
+// Names of the profiled functions and the threads whose counters are live. Only touched when functions
+// are registered, when a thread first records a profile, when it exits, and by a5_profile().
+struct A5ProfileRegistry {
+	mutex lock;
+	vector<string> function_names;
+	unordered_set<A5ThreadProfile *> threads;
+	// Counters of threads that have exited
+	uint64_t retired[A5_MAX_PROFILED_FUNCTIONS][A5_PROFILE_COUNTER_COUNT] = {};
+	// Totals at the last a5_profile_reset(); reported values are relative to them
+	uint64_t baseline[A5_MAX_PROFILED_FUNCTIONS][A5_PROFILE_COUNTER_COUNT] = {};
+};
+
+static A5ProfileRegistry &A5GetProfileRegistry() {
+	static A5ProfileRegistry registry;
+	return registry;
+}
+
+struct A5ThreadProfile {
+	A5ThreadProfile() {
+		auto &registry = A5GetProfileRegistry();
+		lock_guard<mutex> guard(registry.lock);
+		registry.threads.insert(this);
+	}
+
+	~A5ThreadProfile() {
+		auto &registry = A5GetProfileRegistry();
+		lock_guard<mutex> guard(registry.lock);
+		for (idx_t f = 0; f < A5_MAX_PROFILED_FUNCTIONS; f++) {
+			for (idx_t c = 0; c < A5_PROFILE_COUNTER_COUNT; c++) {
+				registry.retired[f][c] += functions[f].Get(c);
+			}
+		}
+		registry.threads.erase(this);
+	}
+
+	A5FunctionCounters functions[A5_MAX_PROFILED_FUNCTIONS] = {};
+};
+
+// Created on the first profiled call of a thread, so threads never see the memory while profiling is off
+static A5ThreadProfile &A5GetThreadProfile() {
+	thread_local A5ThreadProfile profile;
+	return profile;
+}
+
+// Sums the counters of all threads, relative to the last reset
+static void A5CollectProfile(uint64_t totals[A5_MAX_PROFILED_FUNCTIONS][A5_PROFILE_COUNTER_COUNT],
+                             vector<string> &names) {
+	auto &registry = A5GetProfileRegistry();
+	lock_guard<mutex> guard(registry.lock);
+	names = registry.function_names;
+	for (idx_t f = 0; f < names.size(); f++) {
+		for (idx_t c = 0; c < A5_PROFILE_COUNTER_COUNT; c++) {
+			uint64_t total = registry.retired[f][c];
+			for (auto thread : registry.threads) {
+				total += thread->functions[f].Get(c);
+			}
+			totals[f][c] = total - registry.baseline[f][c];
+		}
+	}
+}
+
+static idx_t A5ListSize(Vector &result) {
+	return result.GetType().id() == LogicalTypeId::LIST ? ListVector::GetListSize(result) : 0;
+}
+
+// Wraps a scalar implementation with the profiling counters. When profiling is disabled, the only work
+// added to a chunk is one relaxed load of the enabled flag.
+static scalar_function_t A5ProfiledFunction(idx_t function_id, scalar_function_t function) {
+	return [function_id, function](DataChunk &args, ExpressionState &state, Vector &result) {
+		if (!a5_profiling_enabled.load(std::memory_order_relaxed)) {
+			function(args, state, result);
+			return;
+		}
+		auto &counters = A5GetThreadProfile().functions[function_id];
+		auto list_size = A5ListSize(result);
+		auto start = std::chrono::steady_clock::now();
+		try {
+			function(args, state, result);
+		} catch (...) {
+			counters.Add(A5ProfileCounter::ERRORS, 1);
+			throw;
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		counters.Add(A5ProfileCounter::CALLS, 1);
+		counters.Add(A5ProfileCounter::ROWS, args.size());
+		// List functions report the elements they produced, all others one value per row
+		counters.Add(A5ProfileCounter::ELEMENTS,
+		             result.GetType().id() == LogicalTypeId::LIST ? A5ListSize(result) - list_size : args.size());
+		counters.Add(A5ProfileCounter::NANOS,
+		             NumericCast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+	};
+}
+
+void A5RegisterScalarFunction(ExtensionLoader &loader, CreateScalarFunctionInfo info) {
+	idx_t function_id;
+	{
+		auto &registry = A5GetProfileRegistry();
+		lock_guard<mutex> guard(registry.lock);
+		auto &names = registry.function_names;
+		auto entry = std::find(names.begin(), names.end(), info.name);
+		function_id = NumericCast<idx_t>(entry - names.begin());
+		if (entry == names.end()) {
+			if (names.size() >= A5_MAX_PROFILED_FUNCTIONS) {
+				throw InternalException("a5: more than %llu scalar functions registered for profiling; raise "
+				                        "A5_MAX_PROFILED_FUNCTIONS",
+				                        A5_MAX_PROFILED_FUNCTIONS);
+			}
+			names.push_back(info.name);
+		}
+	}
+	auto &db = loader.GetDatabaseInstance();
+	for (auto &function : info.functions.functions) {
+		function.function = A5RoutedFunction(db, std::move(function.function));
+		function.function = A5LookupTableFunction(db, std::move(function.function));
+		function.function = A5ProfiledFunction(function_id, std::move(function.function));
+	}
+	loader.RegisterFunction(std::move(info));
+}
+
+static void A5SetProfiling(ClientContext &context, SetScope scope, Value &parameter) {
+	a5_profiling_enabled.store(!parameter.IsNull() && BooleanValue::Get(parameter), std::memory_order_relaxed);
+}
+
+struct A5ProfileState : public GlobalTableFunctionState {
+	uint64_t totals[A5_MAX_PROFILED_FUNCTIONS][A5_PROFILE_COUNTER_COUNT];
+	vector<string> names;
+	idx_t next_function = 0;
+};
+
+static unique_ptr<FunctionData> A5ProfileBind(ClientContext &context, TableFunctionBindInput &input,
+                                              vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("function_name");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("calls");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("rows");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("output_elements");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("errors");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("total_ms");
+	return_types.emplace_back(LogicalType::DOUBLE);
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> A5ProfileInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto state = make_uniq<A5ProfileState>();
+	A5CollectProfile(state->totals, state->names);
+	return std::move(state);
+}
+
+static void A5ProfileFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = data.global_state->Cast<A5ProfileState>();
+	idx_t count = 0;
+	for (; state.next_function < state.names.size() && count < STANDARD_VECTOR_SIZE; state.next_function++) {
+		auto &totals = state.totals[state.next_function];
+		if (totals[static_cast<idx_t>(A5ProfileCounter::CALLS)] == 0 &&
+		    totals[static_cast<idx_t>(A5ProfileCounter::ERRORS)] == 0) {
+			continue;
+		}
+		output.SetValue(0, count, Value(state.names[state.next_function]));
+		output.SetValue(1, count, Value::UBIGINT(totals[static_cast<idx_t>(A5ProfileCounter::CALLS)]));
+		output.SetValue(2, count, Value::UBIGINT(totals[static_cast<idx_t>(A5ProfileCounter::ROWS)]));
+		output.SetValue(3, count, Value::UBIGINT(totals[static_cast<idx_t>(A5ProfileCounter::ELEMENTS)]));
+		output.SetValue(4, count, Value::UBIGINT(totals[static_cast<idx_t>(A5ProfileCounter::ERRORS)]));
+		output.SetValue(5, count,
+		                Value::DOUBLE(static_cast<double>(totals[static_cast<idx_t>(A5ProfileCounter::NANOS)]) / 1e6));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+struct A5ProfileResetState : public GlobalTableFunctionState {
+	bool done = false;
+};
+
+static unique_ptr<FunctionData> A5ProfileResetBind(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("success");
+	return_types.emplace_back(LogicalType::BOOLEAN);
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> A5ProfileResetInit(ClientContext &context,
+                                                               TableFunctionInitInput &input) {
+	return make_uniq<A5ProfileResetState>();
+}
+
+// Moves the baseline to the current totals instead of clearing the counters, which other threads own
+static void A5ProfileResetFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = data.global_state->Cast<A5ProfileResetState>();
+	if (state.done) {
+		output.SetCardinality(0);
+		return;
+	}
+	auto &registry = A5GetProfileRegistry();
+	lock_guard<mutex> guard(registry.lock);
+	for (idx_t f = 0; f < registry.function_names.size(); f++) {
+		for (idx_t c = 0; c < A5_PROFILE_COUNTER_COUNT; c++) {
+			uint64_t total = registry.retired[f][c];
+			for (auto thread : registry.threads) {
+				total += thread->functions[f].Get(c);
+			}
+			registry.baseline[f][c] = total;
+		}
+	}
+	state.done = true;
+	output.SetValue(0, 0, Value::BOOLEAN(true));
+	output.SetCardinality(1);
+}
+
+void RegisterA5Profiling(ExtensionLoader &loader) {
+	auto &config = DBConfig::GetConfig(loader.GetDatabaseInstance());
+	config.AddExtensionOption(A5_PROFILING_SETTING,
+	                          "Collect per-function call, row, output and timing counters for a5_profile(); applies "
+	                          "to every connection in the process",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false), A5SetProfiling);
+
+	// a5_profile: Reports the profiling counters of the a5 scalar functions
+	{
+		TableFunction func("a5_profile", {}, A5ProfileFunction, A5ProfileBind, A5ProfileInit);
+		CreateTableFunctionInfo info(func);
+		FunctionDescription desc;
+		desc.description = "Returns the calls, rows, output elements, errors and total time of every a5 scalar "
+		                   "function executed while the a5_profiling setting was enabled";
+		desc.examples = {"SELECT * FROM a5_profile() ORDER BY total_ms DESC"};
+		desc.categories = {"a5", "geospatial"};
+		info.descriptions.push_back(std::move(desc));
+		A5RegisterTableFunction(loader, std::move(info));
+	}
+
+	// a5_profile_reset: Restarts the profiling counters from zero
+	{
+		TableFunction func("a5_profile_reset", {}, A5ProfileResetFunction, A5ProfileResetBind, A5ProfileResetInit);
+		CreateTableFunctionInfo info(func);
+		FunctionDescription desc;
+		desc.description = "Restarts the counters reported by a5_profile() from zero";
+		desc.examples = {"CALL a5_profile_reset()"};
+		desc.categories = {"a5", "geospatial"};
+		info.descriptions.push_back(std::move(desc));
+		A5RegisterTableFunction(loader, std::move(info));
+	}
+}
+
+} // namespace duckdb
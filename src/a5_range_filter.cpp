@@ -0,0 +1,408 @@
+#include "a5_common.hpp"
+#include "a5_index.hpp"
+#include "a5_lookup_table.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_comparison_expression.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression/bound_operator_expression.hpp"
+#include "duckdb/planner/operator/logical_filter.hpp"
+
+#include <algorithm>
+
+namespace duckdb {
+
+// Hull of the index ranges that can satisfy a "cell within parent" predicate on a column
+struct A5ParentRange {
+	uint64_t lo = NumericLimits<uint64_t>::Maximum();
+	uint64_t hi = 0;
+
+	// Adds every cell whose ancestor at `resolution` is `parent`. Returns false when the range cannot be
+	// computed inline, in which case no range filter is derived.
+	bool Add(uint64_t parent, int32_t resolution) {
+		int32_t parent_resolution;
+		if (!a5_index::GetResolution(parent, parent_resolution)) {
+			// Resolution 30 parents only match themselves; anything else is left alone
+			return resolution == MAX_RESOLUTION && a5_get_resolution(parent) == MAX_RESOLUTION && Extend(parent, parent);
+		}
+		if (parent_resolution != resolution) {
+			// A parent at another resolution never matches, so it adds nothing to the range
+			return true;
+		}
+		uint64_t range_lo, range_hi;
+		if (!a5_index::CellToRange(parent, range_lo, range_hi)) {
+			return false;
+		}
+		// The range of a resolution 0 cell covers its descendants but not the cell itself
+		Extend(parent, parent);
+		return Extend(range_lo, range_hi);
+	}
+
+	bool Extend(uint64_t range_lo, uint64_t range_hi) {
+		lo = MinValue(lo, range_lo);
+		hi = MaxValue(hi, range_hi);
+		return true;
+	}
+
+	bool IsEmpty() const {
+		return lo > hi;
+	}
+};
+
+// Matches a5_cell_to_parent(column, constant) and returns the column and the resolution
+static optional_ptr<Expression> A5MatchCellToParent(ClientContext &context, Expression &expr, int32_t &resolution) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+		return nullptr;
+	}
+	auto &func = expr.Cast<BoundFunctionExpression>();
+	if (func.function.name != "a5_cell_to_parent" || func.children.size() != 2 ||
+	    func.children[0]->GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF ||
+	    !func.children[1]->IsFoldable()) {
+		return nullptr;
+	}
+	auto value = ExpressionExecutor::EvaluateScalar(context, *func.children[1]);
+	if (value.IsNull()) {
+		return nullptr;
+	}
+	resolution = value.GetValue<int32_t>();
+	if (resolution < 0 || resolution > MAX_RESOLUTION) {
+		return nullptr;
+	}
+	return func.children[0].get();
+}
+
+// Evaluates a constant parent cell expression into the range
+static bool A5AddConstantParent(ClientContext &context, Expression &expr, int32_t resolution, A5ParentRange &range) {
+	if (!expr.IsFoldable()) {
+		return false;
+	}
+	auto value = ExpressionExecutor::EvaluateScalar(context, expr);
+	if (value.IsNull()) {
+		// NULL never compares equal, so it constrains nothing
+		return true;
+	}
+	if (value.type().id() == LogicalTypeId::LIST) {
+		for (auto &child : ListValue::GetChildren(value)) {
+			if (!child.IsNull() && !range.Add(child.DefaultCastAs(LogicalType::UBIGINT).GetValue<uint64_t>(), resolution)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	return range.Add(value.DefaultCastAs(LogicalType::UBIGINT).GetValue<uint64_t>(), resolution);
+}
+
+// Recognizes, for a column `col` and constants `X`:
+//   a5_cell_to_parent(col, r) = X
+//   a5_cell_to_parent(col, r) IN (X1, X2, ...)
+//   list_contains([X1, X2, ...], a5_cell_to_parent(col, r)), e.g. with the output of a5_compact
+static optional_ptr<Expression> A5MatchParentPredicate(ClientContext &context, Expression &expr, A5ParentRange &range) {
+	int32_t resolution;
+	if (expr.GetExpressionType() == ExpressionType::COMPARE_EQUAL) {
+		auto &comparison = expr.Cast<BoundComparisonExpression>();
+		auto column = A5MatchCellToParent(context, *comparison.left, resolution);
+		auto &constant = column ? *comparison.right : *comparison.left;
+		if (!column) {
+			column = A5MatchCellToParent(context, *comparison.right, resolution);
+		}
+		if (column && A5AddConstantParent(context, constant, resolution, range)) {
+			return column;
+		}
+		return nullptr;
+	}
+	if (expr.GetExpressionType() == ExpressionType::COMPARE_IN) {
+		auto &in = expr.Cast<BoundOperatorExpression>();
+		auto column = A5MatchCellToParent(context, *in.children[0], resolution);
+		if (!column) {
+			return nullptr;
+		}
+		for (idx_t i = 1; i < in.children.size(); i++) {
+			if (!A5AddConstantParent(context, *in.children[i], resolution, range)) {
+				return nullptr;
+			}
+		}
+		return column;
+	}
+	if (expr.GetExpressionClass() == ExpressionClass::BOUND_FUNCTION) {
+		auto &func = expr.Cast<BoundFunctionExpression>();
+		auto &name = func.function.name;
+		if ((name != "list_contains" && name != "list_has" && name != "array_contains" && name != "array_has") ||
+		    func.children.size() != 2) {
+			return nullptr;
+		}
+		auto column = A5MatchCellToParent(context, *func.children[1], resolution);
+		if (column && A5AddConstantParent(context, *func.children[0], resolution, range)) {
+			return column;
+		}
+	}
+	return nullptr;
+}
+
+// Cell sets beyond this size only get the range filter; a small IN list can also be answered by
+// probing an index on the column
+static constexpr idx_t A5_MAX_IN_FILTER_CELLS = 128;
+
+// Whether `list` is known to hold cells compared against `column`: it is produced by an a5 function,
+// or the column is stored as A5CELL
+static bool A5IsCellList(Expression &list, Expression &column) {
+	if (column.return_type.HasAlias() && column.return_type.GetAlias() == "A5CELL") {
+		return true;
+	}
+	if (list.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+		return false;
+	}
+	return StringUtil::StartsWith(list.Cast<BoundFunctionExpression>().function.name, "a5_");
+}
+
+// Recognizes list_contains(cells, col) for a constant cell set such as a5_grid_disk(X, k) or
+// a5_spherical_cap(X, r), and collects its cells
+static optional_ptr<Expression> A5MatchCellSetPredicate(ClientContext &context, Expression &expr,
+                                                        vector<uint64_t> &cells) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+		return nullptr;
+	}
+	auto &func = expr.Cast<BoundFunctionExpression>();
+	auto &name = func.function.name;
+	if ((name != "list_contains" && name != "list_has" && name != "array_contains" && name != "array_has") ||
+	    func.children.size() != 2) {
+		return nullptr;
+	}
+	auto &list = *func.children[0];
+	auto &column = *func.children[1];
+	if (column.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF || !list.IsFoldable() ||
+	    !A5IsCellList(list, column)) {
+		return nullptr;
+	}
+	auto value = ExpressionExecutor::EvaluateScalar(context, list);
+	if (value.IsNull() || value.type().id() != LogicalTypeId::LIST) {
+		return nullptr;
+	}
+	for (auto &child : ListValue::GetChildren(value)) {
+		if (!child.IsNull()) {
+			cells.push_back(child.DefaultCastAs(LogicalType::UBIGINT).GetValue<uint64_t>());
+		}
+	}
+	return &column;
+}
+
+// Adds `lo <= column <= hi`
+static void A5AddRangeFilter(Expression &column, uint64_t lo, uint64_t hi, vector<unique_ptr<Expression>> &filters) {
+	auto &type = column.return_type;
+	filters.push_back(make_uniq<BoundComparisonExpression>(
+	    ExpressionType::COMPARE_GREATERTHANOREQUALTO, column.Copy(),
+	    make_uniq<BoundConstantExpression>(Value::UBIGINT(lo).DefaultCastAs(type))));
+	filters.push_back(make_uniq<BoundComparisonExpression>(
+	    ExpressionType::COMPARE_LESSTHANOREQUALTO, column.Copy(),
+	    make_uniq<BoundConstantExpression>(Value::UBIGINT(hi).DefaultCastAs(type))));
+}
+
+// Membership in a constant cell set implies the hull of its cells as a range filter and, for small
+// sets, `column IN (...)`, which an index on the column answers with point lookups
+static void A5AddCellSetFilters(Expression &column, vector<uint64_t> &cells, vector<unique_ptr<Expression>> &filters) {
+	if (cells.empty()) {
+		// No cell can match; the original predicate filters everything, nothing to add
+		return;
+	}
+	std::sort(cells.begin(), cells.end());
+	cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+	A5AddRangeFilter(column, cells.front(), cells.back(), filters);
+	if (cells.size() > 1 && cells.size() <= A5_MAX_IN_FILTER_CELLS) {
+		auto in = make_uniq<BoundOperatorExpression>(ExpressionType::COMPARE_IN, LogicalType::BOOLEAN);
+		in->children.push_back(column.Copy());
+		for (auto cell : cells) {
+			auto value = Value::UBIGINT(cell).DefaultCastAs(column.return_type);
+			in->children.push_back(make_uniq<BoundConstantExpression>(std::move(value)));
+		}
+		filters.push_back(std::move(in));
+	}
+}
+
+// Constant cell sets larger than this get no coordinate filter, computing their bounds costs a boundary
+// per cell at plan time
+static constexpr idx_t A5_MAX_BOUNDS_CELLS = 1024;
+
+// Cell boundaries are sampled along the edges, so the true edges may bulge slightly beyond the bounds of
+// the sampled points. Each cell's bounds are widened by this fraction of their extent.
+static constexpr double A5_BOUNDS_MARGIN = 0.05;
+
+// Longitude/latitude bounds of a set of cells
+struct A5CellBounds {
+	double min_lon = 180;
+	double max_lon = -180;
+	double min_lat = 90;
+	double max_lat = -90;
+
+	// Returns false for cells whose boundary is not a plain lon/lat ring: cells crossing the antimeridian
+	// or around a pole
+	bool Add(uint64_t cell, vector<LonLatDegrees> &ring) {
+		ring.clear();
+		CellBoundaryOptions options;
+		options.closed_ring = false;
+		options.segments = -1;
+		if (A5CellToBoundaryInto(cell, options, A5VectorSink<LonLatDegrees>, &ring) != A5_OK || ring.empty()) {
+			return false;
+		}
+		double cell_min_lon = 180, cell_max_lon = -180, cell_min_lat = 90, cell_max_lat = -90;
+		for (auto &point : ring) {
+			cell_min_lon = MinValue(cell_min_lon, point.lon);
+			cell_max_lon = MaxValue(cell_max_lon, point.lon);
+			cell_min_lat = MinValue(cell_min_lat, point.lat);
+			cell_max_lat = MaxValue(cell_max_lat, point.lat);
+		}
+		// The ring of a cell around a pole spans every longitude as well. A ring crossing the antimeridian
+		// either jumps between +180 and -180 or continues past one of them; a box beyond ±180 would miss the
+		// points the columns store on the other side.
+		if (cell_max_lon - cell_min_lon > 180 || cell_min_lon < -180 || cell_max_lon > 180) {
+			return false;
+		}
+		auto lon_margin = (cell_max_lon - cell_min_lon) * A5_BOUNDS_MARGIN;
+		auto lat_margin = (cell_max_lat - cell_min_lat) * A5_BOUNDS_MARGIN;
+		min_lon = MinValue(min_lon, cell_min_lon - lon_margin);
+		max_lon = MaxValue(max_lon, cell_max_lon + lon_margin);
+		min_lat = MinValue(min_lat, cell_min_lat - lat_margin);
+		max_lat = MaxValue(max_lat, cell_max_lat + lat_margin);
+		return true;
+	}
+};
+
+// Recognizes a5_cell_contains_point(X, lon, lat) and a5_cells_contain_point([X1, ...], lon, lat) for
+// DOUBLE columns lon and lat and constant cells, and computes the bounds of the cells
+static bool A5MatchContainsPointPredicate(ClientContext &context, Expression &expr, A5CellBounds &bounds,
+                                          optional_ptr<Expression> &lon, optional_ptr<Expression> &lat) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+		return false;
+	}
+	auto &func = expr.Cast<BoundFunctionExpression>();
+	auto &name = func.function.name;
+	if ((name != "a5_cell_contains_point" && name != "a5_cells_contain_point") || func.children.size() != 3 ||
+	    !func.children[0]->IsFoldable()) {
+		return false;
+	}
+	for (idx_t i = 1; i < 3; i++) {
+		auto &child = *func.children[i];
+		if (child.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF ||
+		    child.return_type.id() != LogicalTypeId::DOUBLE) {
+			return false;
+		}
+	}
+	auto value = ExpressionExecutor::EvaluateScalar(context, *func.children[0]);
+	if (value.IsNull()) {
+		return false;
+	}
+	vector<uint64_t> cells;
+	if (value.type().id() == LogicalTypeId::LIST) {
+		for (auto &child : ListValue::GetChildren(value)) {
+			if (!child.IsNull()) {
+				cells.push_back(child.DefaultCastAs(LogicalType::UBIGINT).GetValue<uint64_t>());
+			}
+		}
+	} else {
+		cells.push_back(value.DefaultCastAs(LogicalType::UBIGINT).GetValue<uint64_t>());
+	}
+	if (cells.empty() || cells.size() > A5_MAX_BOUNDS_CELLS) {
+		return false;
+	}
+	vector<LonLatDegrees> ring;
+	for (auto cell : cells) {
+		if (!bounds.Add(cell, ring)) {
+			return false;
+		}
+	}
+	lon = func.children[1].get();
+	lat = func.children[2].get();
+	return true;
+}
+
+// Adds `lo <= column <= hi`, keeping coordinates outside [domain_lo, domain_hi]: the point lookup wraps
+// or rejects those itself
+static void A5AddCoordinateFilter(Expression &column, double lo, double hi, double domain_lo, double domain_hi,
+                                  vector<unique_ptr<Expression>> &filters) {
+	auto compare = [&](ExpressionType type, double constant) -> unique_ptr<Expression> {
+		return make_uniq<BoundComparisonExpression>(type, column.Copy(),
+		                                            make_uniq<BoundConstantExpression>(Value::DOUBLE(constant)));
+	};
+	auto in_bounds =
+	    make_uniq<BoundConjunctionExpression>(ExpressionType::CONJUNCTION_AND,
+	                                          compare(ExpressionType::COMPARE_GREATERTHANOREQUALTO, lo),
+	                                          compare(ExpressionType::COMPARE_LESSTHANOREQUALTO, hi));
+	auto outside_domain = make_uniq<BoundConjunctionExpression>(
+	    ExpressionType::CONJUNCTION_OR, compare(ExpressionType::COMPARE_LESSTHAN, domain_lo),
+	    compare(ExpressionType::COMPARE_GREATERTHAN, domain_hi));
+	filters.push_back(make_uniq<BoundConjunctionExpression>(ExpressionType::CONJUNCTION_OR, std::move(in_bounds),
+	                                                        std::move(outside_domain)));
+}
+
+static void A5CollectRangeFilters(ClientContext &context, Expression &expr, vector<unique_ptr<Expression>> &filters) {
+	if (expr.GetExpressionType() == ExpressionType::CONJUNCTION_AND) {
+		for (auto &child : expr.Cast<BoundConjunctionExpression>().children) {
+			A5CollectRangeFilters(context, *child, filters);
+		}
+		return;
+	}
+	A5CellBounds bounds;
+	optional_ptr<Expression> lon, lat;
+	if (A5MatchContainsPointPredicate(context, expr, bounds, lon, lat)) {
+		A5AddCoordinateFilter(*lon, bounds.min_lon, bounds.max_lon, -180, 180, filters);
+		A5AddCoordinateFilter(*lat, bounds.min_lat, bounds.max_lat, -90, 90, filters);
+		return;
+	}
+	A5ParentRange range;
+	auto column = A5MatchParentPredicate(context, expr, range);
+	if (!column) {
+		vector<uint64_t> cells;
+		column = A5MatchCellSetPredicate(context, expr, cells);
+		if (column) {
+			A5AddCellSetFilters(*column, cells, filters);
+		}
+		return;
+	}
+	if (range.IsEmpty()) {
+		// No constant can match; the original predicate filters everything, nothing to add
+		return;
+	}
+	A5AddRangeFilter(*column, range.lo, range.hi, filters);
+}
+
+// Descendants of a cell occupy one contiguous index range, so a "cell within parent" predicate implies
+// `col BETWEEN lo AND hi`, and membership in a constant cell set implies the hull of its cells. A point
+// in constant cells implies the lon/lat bounds of the cells on the coordinate columns. The
+// implied bounds are added next to the original predicate before filter pushdown runs, which moves them
+// into the scan where zone maps and Parquet statistics skip row groups, and where an index on the
+// column can answer them with a lookup.
+static void A5AddRangeFilters(ClientContext &context, LogicalOperator &op) {
+	for (auto &child : op.children) {
+		A5AddRangeFilters(context, *child);
+	}
+	if (op.type != LogicalOperatorType::LOGICAL_FILTER) {
+		return;
+	}
+	auto &filter = op.Cast<LogicalFilter>();
+	vector<unique_ptr<Expression>> range_filters;
+	for (auto &expr : filter.expressions) {
+		A5CollectRangeFilters(context, *expr, range_filters);
+	}
+	for (auto &range_filter : range_filters) {
+		filter.expressions.push_back(std::move(range_filter));
+	}
+}
+
+static void A5RangeFilterPreOptimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+	// Cell bounds are read from the database's lookup table when it covers them
+	A5LookupTableScope lookup_table(A5GetLookupTable(input.context));
+	A5AddRangeFilters(input.context, *plan);
+}
+
+void RegisterA5RangeFilterOptimizer(ExtensionLoader &loader) {
+	auto &config = DBConfig::GetConfig(loader.GetDatabaseInstance());
+	OptimizerExtension extension;
+	extension.pre_optimize_function = A5RangeFilterPreOptimize;
+	config.optimizer_extensions.push_back(std::move(extension));
+}
+
+} // namespace duckdb
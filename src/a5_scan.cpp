@@ -0,0 +1,466 @@
+#include "a5_common.hpp"
+#include "a5_grid_ring.hpp"
+#include "duckdb/catalog/catalog.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+
+namespace duckdb {
+
+// Number of resolution levels a scan expands in one step. 4^5 = 1024 cells per step (1280 below a
+// resolution 0 cell) keeps every frame of the expansion stack well under a single output chunk.
+static constexpr int32_t A5_SCAN_EXPAND_LEVELS = 5;
+
+// Roots are split into at least this many independent work units (when the target resolution
+// allows it) so a scan below one cell can still run on several threads.
+static constexpr idx_t A5_SCAN_MIN_UNITS = 64;
+
+struct A5CellScanBindData : public TableFunctionData {
+	A5CellScanBindData(vector<uint64_t> roots_p, int32_t target_resolution_p, const char *function_name_p)
+	    : roots(std::move(roots_p)), target_resolution(target_resolution_p), function_name(function_name_p) {
+	}
+
+	vector<uint64_t> roots;
+	int32_t target_resolution;
+	const char *function_name;
+	idx_t estimated_cardinality = 0;
+	// Called with column arguments, e.g. from a LATERAL join: the roots and the target resolution arrive per
+	// input row through the in-out function
+	bool in_out = false;
+};
+
+struct A5CellScanGlobalState : public GlobalTableFunctionState {
+	mutex lock;
+	vector<uint64_t> units;
+	idx_t next_unit = 0;
+
+	idx_t MaxThreads() const override {
+		return MaxValue<idx_t>(units.size(), 1);
+	}
+
+	bool NextUnit(uint64_t &unit) {
+		lock_guard<mutex> guard(lock);
+		if (next_unit >= units.size()) {
+			return false;
+		}
+		unit = units[next_unit++];
+		return true;
+	}
+};
+
+struct A5CellScanLocalState : public LocalTableFunctionState {
+	// Cells at a single resolution that are still to be emitted or expanded
+	struct Frame {
+		vector<uint64_t> cells;
+		idx_t position = 0;
+		int32_t resolution = 0;
+	};
+
+	// Depth-first expansion stack; bounded by MAX_RESOLUTION / A5_SCAN_EXPAND_LEVELS + 1 frames
+	vector<Frame> stack;
+
+	// In-out function only: next row of the input chunk, and the roots and target of the current row
+	idx_t input_row = 0;
+	vector<uint64_t> row_roots;
+	idx_t next_row_root = 0;
+	int32_t row_target = 0;
+};
+
+// Roots must not be finer than the target resolution
+static void A5CellScanValidateRoots(const vector<uint64_t> &roots, int32_t target_resolution,
+                                    const char *function_name) {
+	for (auto cell : roots) {
+		auto resolution = a5_get_resolution(cell);
+		if (resolution > target_resolution) {
+			throw InvalidInputException("%s: cell %llu at resolution %d is finer than the target resolution %d",
+			                            function_name, cell, resolution, target_resolution);
+		}
+	}
+}
+
+// Reads the target resolution argument and validates every root against it
+static unique_ptr<FunctionData> A5CellScanBindRoots(vector<uint64_t> roots, const Value &resolution_value,
+                                                    const char *function_name, vector<LogicalType> &return_types,
+                                                    vector<string> &names) {
+	if (resolution_value.IsNull()) {
+		throw InvalidInputException(string(function_name) + ": target resolution must not be NULL");
+	}
+	auto target_resolution = resolution_value.GetValue<int32_t>();
+	ValidateResolution(target_resolution, function_name);
+
+	A5CellScanValidateRoots(roots, target_resolution, function_name);
+	auto result = make_uniq<A5CellScanBindData>(std::move(roots), target_resolution, function_name);
+	for (auto cell : result->roots) {
+		auto resolution = a5_get_resolution(cell);
+		result->estimated_cardinality +=
+		    resolution < 0 ? a5_get_num_cells(target_resolution) : a5_get_num_children(resolution, target_resolution);
+	}
+
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("cell");
+	return std::move(result);
+}
+
+// Without constant arguments (a LATERAL join over a table's cells) the binder passes no inputs
+static unique_ptr<FunctionData> A5CellScanBindInOut(const char *function_name, vector<LogicalType> &return_types,
+                                                    vector<string> &names) {
+	auto result = make_uniq<A5CellScanBindData>(vector<uint64_t>(), 0, function_name);
+	result->in_out = true;
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("cell");
+	return std::move(result);
+}
+
+// Constant roots are read here and split across threads by the scan; column roots are expanded row by row
+// by the in-out function
+static unique_ptr<FunctionData> A5ChildrenScanBind(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<string> &names) {
+	if (input.inputs.empty()) {
+		return A5CellScanBindInOut("a5_children_scan", return_types, names);
+	}
+	vector<uint64_t> roots;
+	if (!input.inputs[0].IsNull()) {
+		roots.push_back(input.inputs[0].GetValue<uint64_t>());
+	}
+	return A5CellScanBindRoots(std::move(roots), input.inputs[1], "a5_children_scan", return_types, names);
+}
+
+static unique_ptr<FunctionData> A5UncompactScanBind(ClientContext &context, TableFunctionBindInput &input,
+                                                    vector<LogicalType> &return_types, vector<string> &names) {
+	if (input.inputs.empty()) {
+		return A5CellScanBindInOut("a5_uncompact_scan", return_types, names);
+	}
+	vector<uint64_t> roots;
+	if (!input.inputs[0].IsNull()) {
+		for (auto &cell : ListValue::GetChildren(input.inputs[0])) {
+			if (!cell.IsNull()) {
+				roots.push_back(cell.GetValue<uint64_t>());
+			}
+		}
+	}
+	return A5CellScanBindRoots(std::move(roots), input.inputs[1], "a5_uncompact_scan", return_types, names);
+}
+
+static unique_ptr<GlobalTableFunctionState> A5CellScanInitGlobal(ClientContext &context,
+                                                                 TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<A5CellScanBindData>();
+	auto result = make_uniq<A5CellScanGlobalState>();
+	result->units = bind_data.roots;
+
+	// Split the roots one level at a time until there is enough work to spread across threads
+	while (result->units.size() < A5_SCAN_MIN_UNITS) {
+		vector<uint64_t> next;
+		bool expanded = false;
+		for (auto cell : result->units) {
+			auto resolution = a5_get_resolution(cell);
+			if (resolution >= bind_data.target_resolution) {
+				next.push_back(cell);
+				continue;
+			}
+			ThrowRustError(a5_cell_to_children_into(cell, resolution + 1, A5VectorSink<uint64_t>, &next),
+			               bind_data.function_name);
+			expanded = true;
+		}
+		if (!expanded) {
+			break;
+		}
+		result->units = std::move(next);
+	}
+	return std::move(result);
+}
+
+static unique_ptr<LocalTableFunctionState> A5CellScanInitLocal(ExecutionContext &context,
+                                                               TableFunctionInitInput &input,
+                                                               GlobalTableFunctionState *global_state) {
+	return make_uniq<A5CellScanLocalState>();
+}
+
+// Expands the units handed out by `next_unit` to the target resolution into `out` from `count` on, until
+// the chunk is full or there are no units left; returns the new count
+template <class NEXT_UNIT>
+static idx_t A5CellScanExpand(A5CellScanLocalState &lstate, int32_t target, const char *function_name, uint64_t *out,
+                              idx_t count, NEXT_UNIT &&next_unit) {
+	auto &stack = lstate.stack;
+	while (count < STANDARD_VECTOR_SIZE) {
+		if (stack.empty()) {
+			uint64_t unit;
+			if (!next_unit(unit)) {
+				break;
+			}
+			A5CellScanLocalState::Frame frame;
+			frame.cells.push_back(unit);
+			frame.resolution = a5_get_resolution(unit);
+			stack.push_back(std::move(frame));
+			continue;
+		}
+
+		auto &frame = stack.back();
+		if (frame.position >= frame.cells.size()) {
+			stack.pop_back();
+			continue;
+		}
+		if (frame.resolution >= target) {
+			auto n = MinValue<idx_t>(frame.cells.size() - frame.position, STANDARD_VECTOR_SIZE - count);
+			memcpy(out + count, frame.cells.data() + frame.position, n * sizeof(uint64_t));
+			frame.position += n;
+			count += n;
+			continue;
+		}
+
+		auto cell = frame.cells[frame.position++];
+		A5CellScanLocalState::Frame child;
+		child.resolution = MinValue<int32_t>(frame.resolution + A5_SCAN_EXPAND_LEVELS, target);
+		ThrowRustError(a5_cell_to_children_into(cell, child.resolution, A5VectorSink<uint64_t>, &child.cells),
+		               function_name);
+		stack.push_back(std::move(child));
+	}
+	return count;
+}
+
+static void A5CellScanFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &bind_data = data.bind_data->Cast<A5CellScanBindData>();
+	auto &gstate = data.global_state->Cast<A5CellScanGlobalState>();
+	auto &lstate = data.local_state->Cast<A5CellScanLocalState>();
+	auto out = FlatVector::GetData<uint64_t>(output.data[0]);
+	auto count = A5CellScanExpand(lstate, bind_data.target_resolution, bind_data.function_name, out, 0,
+	                              [&](uint64_t &unit) { return gstate.NextUnit(unit); });
+	output.SetCardinality(count);
+}
+
+// Reads the roots of one input row of the in-out function; returns false for a NULL root argument
+template <bool LIST>
+static bool A5CellScanReadRow(DataChunk &input, idx_t row, vector<uint64_t> &roots) {
+	roots.clear();
+	UnifiedVectorFormat format;
+	input.data[0].ToUnifiedFormat(input.size(), format);
+	auto idx = format.sel->get_index(row);
+	if (!format.validity.RowIsValid(idx)) {
+		return false;
+	}
+	if (!LIST) {
+		roots.push_back(UnifiedVectorFormat::GetData<uint64_t>(format)[idx]);
+		return true;
+	}
+	auto &entry = UnifiedVectorFormat::GetData<list_entry_t>(format)[idx];
+	auto &child = ListVector::GetEntry(input.data[0]);
+	UnifiedVectorFormat child_format;
+	child.ToUnifiedFormat(ListVector::GetListSize(input.data[0]), child_format);
+	auto child_data = UnifiedVectorFormat::GetData<uint64_t>(child_format);
+	for (idx_t i = entry.offset; i < entry.offset + entry.length; i++) {
+		auto child_idx = child_format.sel->get_index(i);
+		if (child_format.validity.RowIsValid(child_idx)) {
+			roots.push_back(child_data[child_idx]);
+		}
+	}
+	return true;
+}
+
+// Expands the roots of every input row in order, keeping the expansion of one row across calls when it
+// does not fit into a chunk
+template <bool LIST>
+static OperatorResultType A5CellScanInOutFunction(ExecutionContext &context, TableFunctionInput &data,
+                                                  DataChunk &input, DataChunk &output) {
+	auto &bind_data = data.bind_data->Cast<A5CellScanBindData>();
+	auto &lstate = data.local_state->Cast<A5CellScanLocalState>();
+	auto function_name = bind_data.function_name;
+	auto out = FlatVector::GetData<uint64_t>(output.data[0]);
+	idx_t count = 0;
+	while (count < STANDARD_VECTOR_SIZE) {
+		if (lstate.stack.empty() && lstate.next_row_root >= lstate.row_roots.size()) {
+			if (lstate.input_row >= input.size()) {
+				break;
+			}
+			auto row = lstate.input_row++;
+			lstate.next_row_root = 0;
+			if (!A5CellScanReadRow<LIST>(input, row, lstate.row_roots)) {
+				continue;
+			}
+			auto resolution = input.data[1].GetValue(row);
+			if (resolution.IsNull()) {
+				throw InvalidInputException(string(function_name) + ": target resolution must not be NULL");
+			}
+			lstate.row_target = resolution.GetValue<int32_t>();
+			ValidateResolution(lstate.row_target, function_name);
+			A5CellScanValidateRoots(lstate.row_roots, lstate.row_target, function_name);
+			continue;
+		}
+		count = A5CellScanExpand(lstate, lstate.row_target, function_name, out, count, [&](uint64_t &unit) {
+			if (lstate.next_row_root >= lstate.row_roots.size()) {
+				return false;
+			}
+			unit = lstate.row_roots[lstate.next_row_root++];
+			return true;
+		});
+	}
+	output.SetCardinality(count);
+	if (!lstate.stack.empty() || lstate.next_row_root < lstate.row_roots.size() || lstate.input_row < input.size()) {
+		return OperatorResultType::HAVE_MORE_OUTPUT;
+	}
+	lstate.input_row = 0;
+	return OperatorResultType::NEED_MORE_INPUT;
+}
+
+static unique_ptr<NodeStatistics> A5CellScanCardinality(ClientContext &context, const FunctionData *bind_data_p) {
+	auto &bind_data = bind_data_p->Cast<A5CellScanBindData>();
+	if (bind_data.in_out) {
+		return make_uniq<NodeStatistics>();
+	}
+	return make_uniq<NodeStatistics>(bind_data.estimated_cardinality);
+}
+
+struct A5GridDiskScanBindData : public TableFunctionData {
+	A5GridDiskScanBindData(uint64_t cell_p, int32_t max_k_p) : cell(cell_p), max_k(max_k_p) {
+	}
+
+	uint64_t cell;
+	int32_t max_k;
+};
+
+// Rings are produced in order by a single thread, so the expansion stops wherever the consumer does
+struct A5GridDiskScanState : public GlobalTableFunctionState {
+	A5GridDiskScanState() : expander("a5_grid_disk_scan") {
+	}
+
+	A5GridRingExpander expander;
+	idx_t position = 0;
+	bool finished = false;
+};
+
+static unique_ptr<FunctionData> A5GridDiskScanBind(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<string> &names) {
+	if (input.inputs[1].IsNull()) {
+		throw InvalidInputException("a5_grid_disk_scan: k must not be NULL");
+	}
+	auto max_k = input.inputs[1].GetValue<int32_t>();
+	if (max_k < 0) {
+		throw InvalidInputException("a5_grid_disk_scan: k must be >= 0");
+	}
+	uint64_t cell = 0;
+	if (!input.inputs[0].IsNull()) {
+		cell = input.inputs[0].GetValue<uint64_t>();
+		if (!A5IsValidCell(cell)) {
+			throw InvalidInputException("a5_grid_disk_scan: invalid cell %llu", cell);
+		}
+	} else {
+		// A NULL cell has no neighbours; an empty ring -1 ends the scan immediately
+		max_k = -1;
+	}
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("cell");
+	return_types.emplace_back(LogicalType::INTEGER);
+	names.emplace_back("k");
+	return make_uniq<A5GridDiskScanBindData>(cell, max_k);
+}
+
+static unique_ptr<GlobalTableFunctionState> A5GridDiskScanInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<A5GridDiskScanBindData>();
+	auto result = make_uniq<A5GridDiskScanState>();
+	result->expander.Reset(bind_data.cell);
+	result->finished = bind_data.max_k < 0;
+	return std::move(result);
+}
+
+static void A5GridDiskScanFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &bind_data = data.bind_data->Cast<A5GridDiskScanBindData>();
+	auto &state = data.global_state->Cast<A5GridDiskScanState>();
+	auto &expander = state.expander;
+	A5LookupTableScope lookup_table(A5GetLookupTable(context));
+
+	auto cells = FlatVector::GetData<uint64_t>(output.data[0]);
+	auto ks = FlatVector::GetData<int32_t>(output.data[1]);
+	idx_t count = 0;
+	while (count < STANDARD_VECTOR_SIZE && !state.finished) {
+		auto &ring = expander.Ring();
+		if (state.position >= ring.size()) {
+			// The next ring is only expanded once the previous one has been consumed
+			if (expander.K() >= bind_data.max_k || ring.empty()) {
+				state.finished = true;
+				break;
+			}
+			expander.Next();
+			state.position = 0;
+			continue;
+		}
+		auto n = MinValue<idx_t>(ring.size() - state.position, STANDARD_VECTOR_SIZE - count);
+		memcpy(cells + count, ring.data() + state.position, n * sizeof(uint64_t));
+		for (idx_t i = 0; i < n; i++) {
+			ks[count + i] = expander.K();
+		}
+		state.position += n;
+		count += n;
+	}
+	output.SetCardinality(count);
+}
+
+static unique_ptr<NodeStatistics> A5GridDiskScanCardinality(ClientContext &context, const FunctionData *bind_data_p) {
+	auto &bind_data = bind_data_p->Cast<A5GridDiskScanBindData>();
+	// Rough estimate; rings grow linearly with k
+	auto k = static_cast<idx_t>(MaxValue<int32_t>(bind_data.max_k, 0));
+	return make_uniq<NodeStatistics>(1 + 5 * k * (k + 1) / 2);
+}
+
+// ExtensionLoader has no overload that keeps a table function's descriptions, so documented table
+// functions are created in the system catalog directly.
+void A5RegisterTableFunction(ExtensionLoader &loader, CreateTableFunctionInfo info) {
+	auto &db = loader.GetDatabaseInstance();
+	auto &system_catalog = Catalog::GetSystemCatalog(db);
+	auto transaction = CatalogTransaction::GetSystemTransaction(db);
+	system_catalog.CreateFunction(transaction, info);
+}
+
+void RegisterA5ScanFunctions(ExtensionLoader &loader) {
+	// a5_children_scan: Streams the descendants of a cell at a target resolution
+	{
+		TableFunction func("a5_children_scan", {LogicalType::UBIGINT, LogicalType::INTEGER}, A5CellScanFunction,
+		                   A5ChildrenScanBind, A5CellScanInitGlobal, A5CellScanInitLocal);
+		func.in_out_function = A5CellScanInOutFunction<false>;
+		func.cardinality = A5CellScanCardinality;
+		CreateTableFunctionInfo info(func);
+		FunctionDescription desc;
+		desc.description = "Streams every descendant of an A5 cell at the target resolution without materializing "
+		                   "them as a list";
+		desc.parameter_names = {"cell", "target_resolution"};
+		desc.parameter_types = {LogicalType::UBIGINT, LogicalType::INTEGER};
+		desc.examples = {"SELECT count(*) FROM a5_children_scan(a5_lonlat_to_cell(-122.4, 37.8, 8), 14)"};
+		desc.categories = {"a5", "geospatial"};
+		info.descriptions.push_back(std::move(desc));
+		A5RegisterTableFunction(loader, std::move(info));
+	}
+
+	// a5_grid_disk_scan: Streams the rings of a grid disk, nearest first
+	{
+		TableFunction func("a5_grid_disk_scan", {LogicalType::UBIGINT, LogicalType::INTEGER}, A5GridDiskScanFunction,
+		                   A5GridDiskScanBind, A5GridDiskScanInit);
+		func.cardinality = A5GridDiskScanCardinality;
+		CreateTableFunctionInfo info(func);
+		FunctionDescription desc;
+		desc.description = "Streams the cells within k edge-steps of an A5 cell ring by ring, nearest first, with "
+		                   "their ring number; rings are only expanded as they are consumed, so a LIMIT stops the "
+		                   "expansion";
+		desc.parameter_names = {"cell", "k"};
+		desc.parameter_types = {LogicalType::UBIGINT, LogicalType::INTEGER};
+		desc.examples = {"SELECT * FROM a5_grid_disk_scan(a5_lonlat_to_cell(-122.4, 37.8, 10), 50) LIMIT 10"};
+		desc.categories = {"a5", "geospatial"};
+		info.descriptions.push_back(std::move(desc));
+		A5RegisterTableFunction(loader, std::move(info));
+	}
+
+	// a5_uncompact_scan: Streams the uncompacted cells of a list at a target resolution
+	{
+		TableFunction func("a5_uncompact_scan", {LogicalType::LIST(LogicalType::UBIGINT), LogicalType::INTEGER},
+		                   A5CellScanFunction, A5UncompactScanBind, A5CellScanInitGlobal, A5CellScanInitLocal);
+		func.in_out_function = A5CellScanInOutFunction<true>;
+		func.cardinality = A5CellScanCardinality;
+		CreateTableFunctionInfo info(func);
+		FunctionDescription desc;
+		desc.description = "Streams the expansion of a compacted list of A5 cells at the target resolution without "
+		                   "materializing it as a list";
+		desc.parameter_names = {"cells", "target_resolution"};
+		desc.parameter_types = {LogicalType::LIST(LogicalType::UBIGINT), LogicalType::INTEGER};
+		desc.examples = {"SELECT count(*) FROM a5_uncompact_scan([a5_lonlat_to_cell(-122.4, 37.8, 5)], 10)"};
+		desc.categories = {"a5", "geospatial"};
+		info.descriptions.push_back(std::move(desc));
+		A5RegisterTableFunction(loader, std::move(info));
+	}
+}
+
+} // namespace duckdb
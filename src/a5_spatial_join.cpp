@@ -0,0 +1,242 @@
+#include "a5_common.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/function_binder.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression/bound_unnest_expression.hpp"
+#include "duckdb/planner/joinside.hpp"
+#include "duckdb/planner/operator/logical_any_join.hpp"
+#include "duckdb/planner/operator/logical_comparison_join.hpp"
+#include "duckdb/planner/operator/logical_filter.hpp"
+#include "duckdb/planner/operator/logical_unnest.hpp"
+
+namespace duckdb {
+
+// Setting that enables the ST_DWithin rewrite. The rewrite reads the join columns with ST_X/ST_Y,
+// so it is only correct when both sides hold POINT geometries in lon/lat, and its cap margin rests on a
+// measured rather than proven cell circumradius; it is off by default.
+static constexpr const char *A5_SPATIAL_JOIN_SETTING = "a5_spatial_join";
+
+// Upper bound on the great-circle length, in meters, of one degree of planar lon/lat distance.
+// A degree of longitude is never longer than a degree of latitude on the authalic sphere.
+static constexpr double A5_METERS_PER_DEGREE = 6371007.180918475 * 3.14159265358979323846 / 180.0;
+
+// Finest resolution whose cells are at least as wide as the join radius, so the spherical cap
+// around a point covers only a handful of cells. Returns -1 when even resolution 0 is too fine.
+static int32_t A5SpatialJoinResolution(double radius) {
+	for (int32_t resolution = MAX_RESOLUTION - 1; resolution >= 0; resolution--) {
+		if (std::sqrt(a5_cell_area(resolution)) >= radius) {
+			return resolution;
+		}
+	}
+	return -1;
+}
+
+static unique_ptr<Expression> A5BindFunction(ClientContext &context, const string &name,
+                                             vector<unique_ptr<Expression>> children) {
+	ErrorData error;
+	FunctionBinder binder(context);
+	// Returns nullptr when the function is missing (spatial not loaded) or does not bind
+	return binder.BindScalarFunction(DEFAULT_SCHEMA, name, std::move(children), error);
+}
+
+// a5_lonlat_to_cell(ST_X(geom), ST_Y(geom), resolution)
+static unique_ptr<Expression> A5PointCell(ClientContext &context, const Expression &geom, int32_t resolution) {
+	vector<unique_ptr<Expression>> x_args, y_args;
+	x_args.push_back(geom.Copy());
+	y_args.push_back(geom.Copy());
+	auto x = A5BindFunction(context, "st_x", std::move(x_args));
+	auto y = A5BindFunction(context, "st_y", std::move(y_args));
+	if (!x || !y) {
+		return nullptr;
+	}
+	vector<unique_ptr<Expression>> args;
+	args.push_back(std::move(x));
+	args.push_back(std::move(y));
+	args.push_back(make_uniq<BoundConstantExpression>(Value::INTEGER(resolution)));
+	return A5BindFunction(context, "a5_lonlat_to_cell", std::move(args));
+}
+
+struct A5DWithinMatch {
+	// Geometry arguments that only reference the left and the right child of the join
+	optional_ptr<Expression> left_geom;
+	optional_ptr<Expression> right_geom;
+	double distance = 0;
+};
+
+static bool A5MatchDWithin(ClientContext &context, Expression &expr, const unordered_set<idx_t> &left_bindings,
+                           const unordered_set<idx_t> &right_bindings, A5DWithinMatch &match) {
+	if (expr.GetExpressionClass() == ExpressionClass::BOUND_CONJUNCTION &&
+	    expr.GetExpressionType() == ExpressionType::CONJUNCTION_AND) {
+		for (auto &child : expr.Cast<BoundConjunctionExpression>().children) {
+			if (A5MatchDWithin(context, *child, left_bindings, right_bindings, match)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+		return false;
+	}
+	auto &func = expr.Cast<BoundFunctionExpression>();
+	if (StringUtil::Lower(func.function.name) != "st_dwithin" || func.children.size() != 3 ||
+	    !func.children[2]->IsFoldable()) {
+		return false;
+	}
+	auto distance = ExpressionExecutor::EvaluateScalar(context, *func.children[2]);
+	if (distance.IsNull()) {
+		return false;
+	}
+	match.distance = distance.GetValue<double>();
+	if (match.distance < 0) {
+		return false;
+	}
+
+	auto first_side = JoinSide::GetJoinSide(*func.children[0], left_bindings, right_bindings);
+	auto second_side = JoinSide::GetJoinSide(*func.children[1], left_bindings, right_bindings);
+	if (first_side == JoinSide::LEFT && second_side == JoinSide::RIGHT) {
+		match.left_geom = func.children[0].get();
+		match.right_geom = func.children[1].get();
+		return true;
+	}
+	if (first_side == JoinSide::RIGHT && second_side == JoinSide::LEFT) {
+		match.left_geom = func.children[1].get();
+		match.right_geom = func.children[0].get();
+		return true;
+	}
+	return false;
+}
+
+// Rewrites an inner ANY join on ST_DWithin(a, b, r) into
+//   FILTER(original condition)
+//     COMPARISON_JOIN(a5_lonlat_to_cell(a) = cap_cell)
+//       probe side
+//       UNNEST(a5_spherical_cap(a5_lonlat_to_cell(b), radius + margin)) AS cap_cell
+//         build side
+// Every point within r of b falls in one of the cap cells, and each probe point has a single cell,
+// so every candidate pair is produced exactly once and the residual filter keeps the exact result.
+static unique_ptr<LogicalOperator> A5RewriteDWithinJoin(OptimizerExtensionInput &input, LogicalAnyJoin &join) {
+	auto &context = input.context;
+	if (join.join_type != JoinType::INNER) {
+		return nullptr;
+	}
+
+	unordered_set<idx_t> left_bindings, right_bindings;
+	LogicalJoin::GetTableReferences(*join.children[0], left_bindings);
+	LogicalJoin::GetTableReferences(*join.children[1], right_bindings);
+	A5DWithinMatch match;
+	if (!A5MatchDWithin(context, *join.condition, left_bindings, right_bindings, match)) {
+		return nullptr;
+	}
+
+	auto radius = match.distance * A5_METERS_PER_DEGREE;
+	auto resolution = A5SpatialJoinResolution(radius);
+	if (resolution < 0) {
+		return nullptr;
+	}
+	// Both points can sit up to the largest circumradius away from their cells' centers, so two points
+	// within the radius have centers within the radius plus two circumradii
+	auto cap_radius = radius + 2 * A5MaxCellCircumradius(resolution);
+
+	// Expand the smaller side into its cap cells; that side becomes the build side of the hash join
+	bool expand_left =
+	    join.children[0]->has_estimated_cardinality && join.children[1]->has_estimated_cardinality &&
+	    join.children[0]->estimated_cardinality < join.children[1]->estimated_cardinality;
+	auto &probe_geom = expand_left ? *match.right_geom : *match.left_geom;
+	auto &build_geom = expand_left ? *match.left_geom : *match.right_geom;
+
+	auto probe_cell = A5PointCell(context, probe_geom, resolution);
+	auto build_cell = A5PointCell(context, build_geom, resolution);
+	if (!probe_cell || !build_cell) {
+		return nullptr;
+	}
+	vector<unique_ptr<Expression>> cap_args;
+	cap_args.push_back(std::move(build_cell));
+	cap_args.push_back(make_uniq<BoundConstantExpression>(Value::DOUBLE(cap_radius)));
+	auto compacted_cap = A5BindFunction(context, "a5_spherical_cap", std::move(cap_args));
+	if (!compacted_cap) {
+		return nullptr;
+	}
+	// The cap is compacted, so coarser cells would never equal a probe cell; expand it to the resolution
+	vector<unique_ptr<Expression>> uncompact_args;
+	uncompact_args.push_back(std::move(compacted_cap));
+	uncompact_args.push_back(make_uniq<BoundConstantExpression>(Value::INTEGER(resolution)));
+	auto cap = A5BindFunction(context, "a5_uncompact", std::move(uncompact_args));
+	if (!cap) {
+		return nullptr;
+	}
+
+	auto probe_child = std::move(join.children[expand_left ? 1 : 0]);
+	auto build_child = std::move(join.children[expand_left ? 0 : 1]);
+
+	auto unnest_index = input.optimizer.binder.GenerateTableIndex();
+	auto unnest = make_uniq<LogicalUnnest>(unnest_index);
+	auto unnest_expr = make_uniq<BoundUnnestExpression>(LogicalType::UBIGINT);
+	unnest_expr->child = std::move(cap);
+	unnest->expressions.push_back(std::move(unnest_expr));
+	unnest->children.push_back(std::move(build_child));
+	if (unnest->children[0]->has_estimated_cardinality) {
+		unnest->SetEstimatedCardinality(unnest->children[0]->estimated_cardinality);
+	}
+
+	auto cell_join = make_uniq<LogicalComparisonJoin>(JoinType::INNER);
+	JoinCondition condition;
+	condition.left = std::move(probe_cell);
+	condition.right = make_uniq<BoundColumnRefExpression>(LogicalType::UBIGINT, ColumnBinding(unnest_index, 0));
+	condition.comparison = ExpressionType::COMPARE_EQUAL;
+	cell_join->conditions.push_back(std::move(condition));
+	cell_join->children.push_back(std::move(probe_child));
+	cell_join->children.push_back(std::move(unnest));
+	if (join.has_estimated_cardinality) {
+		cell_join->SetEstimatedCardinality(join.estimated_cardinality);
+	}
+
+	auto filter = make_uniq<LogicalFilter>(std::move(join.condition));
+	filter->children.push_back(std::move(cell_join));
+	if (join.has_estimated_cardinality) {
+		filter->SetEstimatedCardinality(join.estimated_cardinality);
+	}
+	return std::move(filter);
+}
+
+static void A5SpatialJoinRewrite(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &op) {
+	for (auto &child : op->children) {
+		A5SpatialJoinRewrite(input, child);
+	}
+	if (op->type != LogicalOperatorType::LOGICAL_ANY_JOIN) {
+		return;
+	}
+	auto rewritten = A5RewriteDWithinJoin(input, op->Cast<LogicalAnyJoin>());
+	if (rewritten) {
+		op = std::move(rewritten);
+	}
+}
+
+static void A5SpatialJoinOptimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+	Value enabled;
+	if (!input.context.TryGetCurrentSetting(A5_SPATIAL_JOIN_SETTING, enabled) || enabled.IsNull() ||
+	    !BooleanValue::Get(enabled)) {
+		return;
+	}
+	A5SpatialJoinRewrite(input, plan);
+}
+
+void RegisterA5SpatialJoinOptimizer(ExtensionLoader &loader) {
+	auto &config = DBConfig::GetConfig(loader.GetDatabaseInstance());
+	config.AddExtensionOption(A5_SPATIAL_JOIN_SETTING,
+	                          "Rewrite ST_DWithin joins between lon/lat POINT geometries into hash joins on A5 cells "
+	                          "(experimental: the cell margin is measured, not proven, so pairs could be missed)",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+
+	OptimizerExtension extension;
+	extension.optimize_function = A5SpatialJoinOptimize;
+	config.optimizer_extensions.push_back(std::move(extension));
+}
+
+} // namespace duckdb
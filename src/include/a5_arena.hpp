@@ -0,0 +1,127 @@
+#pragma once
+
+#include "a5_common.hpp"
+#include "duckdb/common/allocator.hpp"
+#include "duckdb/execution/expression_executor_state.hpp"
+#include "duckdb/storage/arena_allocator.hpp"
+
+namespace duckdb {
+
+// Allocates uninitialized storage for `count` elements from the arena
+template <class T>
+T *A5ArenaAllocate(ArenaAllocator &arena, idx_t count) {
+	return reinterpret_cast<T *>(arena.AllocateAligned(count * sizeof(T)));
+}
+
+// Growable array whose storage is bump-allocated from a chunk arena. Nothing is freed per row: growing
+// extends the latest allocation in place when possible, and all memory is released together when the
+// arena is reset. A buffer must not be used after a reset of its arena.
+template <class T>
+class A5ArenaBuffer {
+public:
+	explicit A5ArenaBuffer(ArenaAllocator &arena) : arena(arena), data(nullptr), count(0), capacity(0) {
+	}
+
+	// Appends `len` uninitialized elements and returns a pointer to the first one
+	T *Append(idx_t len) {
+		if (count + len > capacity) {
+			auto new_capacity = MaxValue<idx_t>(NextPowerOfTwo(count + len), 8);
+			if (capacity == 0) {
+				data = A5ArenaAllocate<T>(arena, new_capacity);
+			} else {
+				data = reinterpret_cast<T *>(arena.ReallocateAligned(data_ptr_cast(data), capacity * sizeof(T),
+				                                                     new_capacity * sizeof(T)));
+			}
+			capacity = new_capacity;
+		}
+		auto out = data + count;
+		count += len;
+		return out;
+	}
+
+	void PushBack(const T &value) {
+		*Append(1) = value;
+	}
+
+	T PopBack() {
+		return data[--count];
+	}
+
+	// Empties the buffer but keeps its storage for reuse
+	void Clear() {
+		count = 0;
+	}
+
+	idx_t size() const {
+		return count;
+	}
+
+	bool empty() const {
+		return count == 0;
+	}
+
+	T &operator[](idx_t index) {
+		return data[index];
+	}
+
+	const T &operator[](idx_t index) const {
+		return data[index];
+	}
+
+	T *begin() {
+		return data;
+	}
+
+	T *end() {
+		return data + count;
+	}
+
+	const T *begin() const {
+		return data;
+	}
+
+	const T *end() const {
+		return data + count;
+	}
+
+private:
+	ArenaAllocator &arena;
+	T *data;
+	idx_t count;
+	idx_t capacity;
+};
+
+// CellSink / LonLatSink that appends to an A5ArenaBuffer<T> passed as the context
+template <class T>
+T *A5ArenaSink(void *ctx, uintptr_t len) {
+	// Exceptions must not unwind through the Rust frames that called us
+	try {
+		return static_cast<A5ArenaBuffer<T> *>(ctx)->Append(len);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+// Scratch arena owned by one thread's instance of a scalar function
+struct A5ArenaLocalState : public FunctionLocalState {
+	explicit A5ArenaLocalState(Allocator &allocator) : arena(allocator) {
+	}
+
+	ArenaAllocator arena;
+};
+
+// init_local_state for functions that stage intermediate Rust output in a chunk arena
+inline unique_ptr<FunctionLocalState> A5ArenaInitLocalState(ExpressionState &state, const BoundFunctionExpression &expr,
+                                                            FunctionData *bind_data) {
+	return make_uniq<A5ArenaLocalState>(Allocator::Get(state.GetContext()));
+}
+
+// Returns the function's arena, emptied for a new chunk. The arena keeps its first block, so a thread
+// processing chunks of similar rows stops allocating after the first chunk.
+inline ArenaAllocator &A5ChunkArena(ExpressionState &state) {
+	auto &arena = ExecuteFunctionState::GetFunctionState(state)->Cast<A5ArenaLocalState>().arena;
+	arena.Reset();
+	return arena;
+}
+
+} // namespace duckdb
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "a5_common.hpp"
+#include "a5_index.hpp"
+
+#include <algorithm>
+
+namespace duckdb {
+
+// A cell together with the range of indices its descendants occupy
+struct A5CellRange {
+	uint64_t lo;
+	uint64_t hi;
+	uint64_t cell;
+
+	static A5CellRange FromCell(uint64_t cell) {
+		A5CellRange range {cell, cell, cell};
+		a5_index::CellToRange(cell, range.lo, range.hi);
+		return range;
+	}
+};
+
+// Ranges of a set of cells without duplicates and without cells covered by an ancestor in the same
+// set, ordered by lo. The remaining ranges are pairwise disjoint.
+inline void A5DisjointRanges(const uint64_t *cells, idx_t count, vector<A5CellRange> &ranges) {
+	ranges.clear();
+	ranges.reserve(count);
+	for (idx_t i = 0; i < count; i++) {
+		ranges.push_back(A5CellRange::FromCell(cells[i]));
+	}
+	// Ancestors sort before the cells they cover: same or smaller lo, larger hi
+	std::sort(ranges.begin(), ranges.end(), [](const A5CellRange &a, const A5CellRange &b) {
+		return a.lo < b.lo || (a.lo == b.lo && a.hi > b.hi);
+	});
+	idx_t kept = 0;
+	for (auto &range : ranges) {
+		if (kept > 0 && range.lo <= ranges[kept - 1].hi) {
+			continue;
+		}
+		ranges[kept++] = range;
+	}
+	ranges.resize(kept);
+}
+
+// Removes duplicates and every cell that is covered by an ancestor in the same set. a5_compact only
+// merges complete groups of siblings, so sets coming from independently compacted partitions must be
+// normalized first. The result is ordered by descendant range.
+inline void A5RemoveCoveredCells(vector<uint64_t> &cells) {
+	vector<A5CellRange> ranges;
+	A5DisjointRanges(cells.data(), cells.size(), ranges);
+	cells.clear();
+	for (auto &range : ranges) {
+		cells.push_back(range.cell);
+	}
+}
+
+// Normalizes `cells` and compacts them through the Rust implementation
+inline void A5CompactCellSet(vector<uint64_t> &cells, const char *function_name) {
+	A5RemoveCoveredCells(cells);
+	if (cells.empty()) {
+		return;
+	}
+	vector<uint64_t> compacted;
+	compacted.reserve(cells.size());
+	ThrowRustError(a5_compact_into(cells.data(), cells.size(), A5VectorSink<uint64_t>, &compacted), function_name);
+	cells = std::move(compacted);
+}
+
+// Set operations on cell sets of mixed resolutions, typically compacted lists. Both inputs are reduced to
+// disjoint descendant ranges sorted by lo, and since the ranges of two cells are either nested or
+// disjoint, one sorted merge over the ranges decides every pair without expanding any cell.
+class A5CellSetOperations {
+public:
+	explicit A5CellSetOperations(const char *function_name) : function_name(function_name) {
+	}
+
+	// Cells covered by either set
+	void Union(const uint64_t *a, idx_t a_count, const uint64_t *b, idx_t b_count, vector<uint64_t> &out) {
+		out.assign(a, a + a_count);
+		out.insert(out.end(), b, b + b_count);
+		A5CompactCellSet(out, function_name);
+	}
+
+	// Cells covered by both sets: of two overlapping ranges the inner one is the common part
+	void Intersection(const uint64_t *a, idx_t a_count, const uint64_t *b, idx_t b_count, vector<uint64_t> &out) {
+		A5DisjointRanges(a, a_count, a_ranges);
+		A5DisjointRanges(b, b_count, b_ranges);
+		out.clear();
+		idx_t i = 0, j = 0;
+		while (i < a_ranges.size() && j < b_ranges.size()) {
+			auto &a_range = a_ranges[i];
+			auto &b_range = b_ranges[j];
+			if (a_range.hi < b_range.lo) {
+				i++;
+			} else if (b_range.hi < a_range.lo) {
+				j++;
+			} else if (a_range.hi <= b_range.hi) {
+				// Nested: the range ending first lies inside the other and is consumed
+				out.push_back(Contains(b_range, a_range) ? a_range.cell : b_range.cell);
+				i++;
+			} else {
+				out.push_back(Contains(a_range, b_range) ? b_range.cell : a_range.cell);
+				j++;
+			}
+		}
+		// Coarse cells of one set may now be tiled by complete groups of finer cells of the other
+		Compact(out);
+	}
+
+	// Cells covered by `a` but not by `b`. A cell of `a` that partially overlaps `b` is split only along
+	// the paths towards the cells of `b` inside it; its other children are kept whole.
+	void Difference(const uint64_t *a, idx_t a_count, const uint64_t *b, idx_t b_count, vector<uint64_t> &out) {
+		A5DisjointRanges(a, a_count, a_ranges);
+		A5DisjointRanges(b, b_count, b_ranges);
+		out.clear();
+		idx_t j = 0;
+		for (auto &a_range : a_ranges) {
+			while (j < b_ranges.size() && b_ranges[j].hi < a_range.lo) {
+				j++;
+			}
+			if (j < b_ranges.size() && Contains(b_ranges[j], a_range)) {
+				// Removed entirely; the same cell of `b` may cover the next cells of `a` as well
+				continue;
+			}
+			auto end = j;
+			while (end < b_ranges.size() && b_ranges[end].lo <= a_range.hi) {
+				end++;
+			}
+			Subtract(a_range, j, end, out);
+			j = end;
+		}
+		Compact(out);
+	}
+
+	// Whether the cells cover `cell`: one of them is the cell or an ancestor of it, or cells inside it
+	// compact to it
+	bool Covers(const uint64_t *cells, idx_t count, uint64_t cell) {
+		auto target = A5CellRange::FromCell(cell);
+		inside.clear();
+		for (idx_t i = 0; i < count; i++) {
+			auto range = A5CellRange::FromCell(cells[i]);
+			if (range.cell == cell || Contains(range, target)) {
+				return true;
+			}
+			if (Contains(target, range)) {
+				inside.push_back(range.cell);
+			}
+		}
+		if (inside.empty()) {
+			return false;
+		}
+		A5CompactCellSet(inside, function_name);
+		return std::find(inside.begin(), inside.end(), cell) != inside.end();
+	}
+
+private:
+	// Whether `outer` covers `inner`. Distinct cells never have equal ranges, so equal ranges are the same
+	// cell.
+	static bool Contains(const A5CellRange &outer, const A5CellRange &inner) {
+		return outer.lo <= inner.lo && inner.hi <= outer.hi;
+	}
+
+	// Appends the parts of `cell` not covered by b_ranges[begin, end), which all lie inside it
+	void Subtract(const A5CellRange &cell, idx_t begin, idx_t end, vector<uint64_t> &out) {
+		if (begin == end) {
+			out.push_back(cell.cell);
+			return;
+		}
+		if (Contains(b_ranges[begin], cell)) {
+			return;
+		}
+		vector<uint64_t> children;
+		ThrowRustError(
+		    a5_cell_to_children_into(cell.cell, a5_get_resolution(cell.cell) + 1, A5VectorSink<uint64_t>, &children),
+		    function_name);
+		// Children are visited in index order, so each takes the next run of the sorted b_ranges
+		std::sort(children.begin(), children.end());
+		for (auto child : children) {
+			auto child_range = A5CellRange::FromCell(child);
+			while (begin < end && b_ranges[begin].hi < child_range.lo) {
+				begin++;
+			}
+			auto child_end = begin;
+			while (child_end < end && b_ranges[child_end].lo <= child_range.hi) {
+				child_end++;
+			}
+			Subtract(child_range, begin, child_end, out);
+			begin = child_end;
+		}
+	}
+
+	void Compact(vector<uint64_t> &cells) {
+		if (cells.empty()) {
+			return;
+		}
+		compacted.clear();
+		ThrowRustError(a5_compact_into(cells.data(), cells.size(), A5VectorSink<uint64_t>, &compacted),
+		               function_name);
+		std::swap(cells, compacted);
+	}
+
+	const char *function_name;
+	vector<A5CellRange> a_ranges;
+	vector<A5CellRange> b_ranges;
+	vector<uint64_t> inside;
+	vector<uint64_t> compacted;
+};
+
+} // namespace duckdb
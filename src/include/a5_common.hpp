@@ -0,0 +1,137 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/parser/parsed_data/create_scalar_function_info.hpp"
+#include "duckdb/parser/parsed_data/create_table_function_info.hpp"
+#include "a5_index.hpp"
+#include "rust.h"
+
+namespace duckdb {
+
+#define MAX_RESOLUTION 30
+
+// Helper function to validate resolution and throw with a clear error message
+inline bool IsValidResolution(int32_t resolution) {
+	return resolution >= 0 && resolution <= MAX_RESOLUTION;
+}
+
+inline void ValidateResolution(int32_t resolution, const char *function_name) {
+	if (!IsValidResolution(resolution)) {
+		throw InvalidInputException(string(function_name) + ": Resolution must be between 0 and 30");
+	}
+}
+
+// Formats the message of a failed Rust call. Only called once a row is known to fail, so the
+// message is not materialized for rows that TRY_ functions turn into NULL.
+inline string A5ErrorMessage(int32_t error_code) {
+	if (error_code == A5_ERROR_ALLOCATION) {
+		return "failed to allocate output buffer";
+	}
+	uintptr_t len = 0;
+	auto message = a5_last_error_message(&len);
+	return string(message, len);
+}
+
+// Throws the error of a failed Rust call; does nothing for A5_OK
+inline void ThrowRustError(int32_t error_code, const char *function_name) {
+	if (error_code != A5_OK) {
+		throw InvalidInputException(string(function_name) + ": " + A5ErrorMessage(error_code));
+	}
+}
+
+// Resolution of a cell, inline where the index allows it
+inline int32_t A5GetResolution(uint64_t cell) {
+	int32_t resolution;
+	if (a5_index::GetResolution(cell, resolution)) {
+		return resolution;
+	}
+	return a5_get_resolution(cell);
+}
+
+inline bool A5IsValidCell(uint64_t cell) {
+	bool valid;
+	if (a5_index::IsValidCell(cell, valid)) {
+		return valid;
+	}
+	// Only resolution 30 cells carry no marker bit, so anything else is malformed
+	return a5_get_resolution(cell) == MAX_RESOLUTION && a5_index::HasValidPrefix(cell, MAX_RESOLUTION);
+}
+
+// CellSink / LonLatSink that appends to a vector<T> passed as the context
+template <class T>
+T *A5VectorSink(void *ctx, uintptr_t len) {
+	auto &values = *static_cast<vector<T> *>(ctx);
+	auto offset = values.size();
+	try {
+		values.resize(offset + len);
+	} catch (...) {
+		return nullptr;
+	}
+	return values.data() + offset;
+}
+
+// The resolution 0 cells never change, so they are fetched from Rust once per process
+inline const vector<uint64_t> &A5Res0Cells() {
+	static const vector<uint64_t> res0_cells = [] {
+		auto cells = a5_get_res0_cells();
+		vector<uint64_t> result(cells.data, cells.data + cells.len);
+		a5_free_cell_array(cells);
+		return result;
+	}();
+	return res0_cells;
+}
+
+// Upper bound, in meters, on the great-circle distance from a cell's center to any point of the cell, over
+// all cells of the resolution. Measured on first use (a5_extension.cpp).
+double A5MaxCellCircumradius(int32_t resolution);
+
+// Registers a table function together with its descriptions
+void A5RegisterTableFunction(ExtensionLoader &loader, CreateTableFunctionInfo info);
+
+// Registers a scalar function with its overloads wrapped by the profiling counters, and by the allocator
+// route and lookup table of the database (a5_profile.cpp)
+void A5RegisterScalarFunction(ExtensionLoader &loader, CreateScalarFunctionInfo info);
+
+// UBIGINT aliased as A5CELL, with hex casts to and from VARCHAR (a5_cell_type.cpp)
+LogicalType A5CellType();
+void RegisterA5CellType(ExtensionLoader &loader);
+
+// Aggregate functions over cells (a5_aggregates.cpp)
+void RegisterA5AggregateFunctions(ExtensionLoader &loader);
+
+// Streaming cell enumeration table functions (a5_scan.cpp)
+void RegisterA5ScanFunctions(ExtensionLoader &loader);
+
+// Polygon coverage functions (a5_polyfill.cpp)
+void RegisterA5PolyfillFunctions(ExtensionLoader &loader);
+
+// Dissolving cell sets into outlines (a5_dissolve.cpp)
+void RegisterA5DissolveFunctions(ExtensionLoader &loader);
+
+// Neighborhood cache setting and statistics (a5_neighborhood_cache.cpp)
+void RegisterA5NeighborhoodCache(ExtensionLoader &loader);
+
+// a5_profiling setting and the a5_profile / a5_profile_reset table functions (a5_profile.cpp)
+void RegisterA5Profiling(ExtensionLoader &loader);
+
+// Optimizer rule deriving index range filters from a5_cell_to_parent predicates (a5_range_filter.cpp)
+void RegisterA5RangeFilterOptimizer(ExtensionLoader &loader);
+
+// a5_duckdb_allocator setting routing Rust allocations through DuckDB (a5_allocator.cpp)
+void RegisterA5Allocator(ExtensionLoader &loader);
+// Wraps a scalar implementation so the Rust library allocates from the database's buffer allocator while
+// a5_duckdb_allocator is enabled in it (a5_allocator.cpp)
+scalar_function_t A5RoutedFunction(DatabaseInstance &db, scalar_function_t function);
+
+// Wraps a scalar implementation so it reads cell geometry from the lookup table loaded in the database
+// (a5_lookup_table.cpp)
+scalar_function_t A5LookupTableFunction(DatabaseInstance &db, scalar_function_t function);
+
+// a5_lookup_table setting and the a5_write_lookup_table table function (a5_lookup_table.cpp)
+void RegisterA5LookupTable(ExtensionLoader &loader);
+
+// Optimizer rule rewriting ST_DWithin joins into A5 cell hash joins (a5_spatial_join.cpp)
+void RegisterA5SpatialJoinOptimizer(ExtensionLoader &loader);
+
+} // namespace duckdb
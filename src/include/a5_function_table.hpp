@@ -0,0 +1,56 @@
+#pragma once
+
+#include "a5_common.hpp"
+#include "duckdb/function/scalar_function.hpp"
+
+namespace duckdb {
+
+// Argument and return types of the scalar functions. Tables refer to them by tag so they stay constant
+// data; the LogicalTypes are only built when the functions are registered.
+enum class A5Type : uint8_t {
+	NONE = 0,
+	INTEGER,
+	UBIGINT,
+	DOUBLE,
+	BOOLEAN,
+	VARCHAR,
+	BLOB,
+	// [lon, lat] or [theta, phi]: DOUBLE[2]
+	POINT,
+	// [min, max] cell index range: UBIGINT[2]
+	CELL_RANGE,
+	// UBIGINT[]
+	CELL_LIST,
+	// DOUBLE[2][]
+	RING
+};
+
+static constexpr idx_t A5_MAX_FUNCTION_ARGUMENTS = 4;
+
+typedef void (*a5_scalar_function_ptr_t)(DataChunk &args, ExpressionState &state, Vector &result);
+
+// One overload of a scalar function together with its documentation. Consecutive entries with the same
+// name are registered as the overloads of one function.
+struct A5ScalarFunctionEntry {
+	const char *name;
+	A5Type arguments[A5_MAX_FUNCTION_ARGUMENTS];
+	A5Type return_type;
+	a5_scalar_function_ptr_t function;
+	const char *description;
+	const char *parameter_names[A5_MAX_FUNCTION_ARGUMENTS];
+	const char *example;
+	// Optional
+	function_statistics_t statistics;
+	init_local_state_t init_local_state;
+};
+
+// Registers the functions of a table, documented with the "a5" and "geospatial" categories. Constant
+// and dictionary inputs are evaluated once per distinct value.
+void A5RegisterScalarFunctions(ExtensionLoader &loader, const A5ScalarFunctionEntry *entries, idx_t count);
+
+template <idx_t N>
+void A5RegisterScalarFunctions(ExtensionLoader &loader, const A5ScalarFunctionEntry (&entries)[N]) {
+	A5RegisterScalarFunctions(loader, entries, N);
+}
+
+} // namespace duckdb
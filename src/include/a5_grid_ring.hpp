@@ -0,0 +1,84 @@
+#pragma once
+
+#include "a5_common.hpp"
+#include "a5_lookup_table.hpp"
+#include "duckdb/common/unordered_set.hpp"
+
+#include <algorithm>
+
+namespace duckdb {
+
+// Rings searched at most by a5_grid_distance. Ring k holds O(k) cells, so reaching it costs O(k²) neighbour
+// lookups in total.
+static constexpr int32_t A5_MAX_GRID_DISTANCE = 1000;
+
+// Expands the rings of cells around a cell one at a time: ring k holds the cells exactly k edge-steps
+// away, so the disk of a5_grid_disk(cell, k) is the union of rings 0 to k. Every neighbour of a cell in
+// ring k - 1 lies in ring k - 2, k - 1 or k, so only the two previous rings are kept and memory stays
+// proportional to the ring size.
+class A5GridRingExpander {
+public:
+	explicit A5GridRingExpander(const char *function_name) : function_name(function_name), k(0) {
+	}
+
+	void Reset(uint64_t origin) {
+		previous.clear();
+		current.assign(1, origin);
+		seen.clear();
+		seen.insert(origin);
+		k = 0;
+	}
+
+	// Cells of ring k, sorted
+	const vector<uint64_t> &Ring() const {
+		return current;
+	}
+
+	int32_t K() const {
+		return k;
+	}
+
+	// Advances to ring k + 1. An empty ring means the whole grid has been covered.
+	void Next() {
+		next.clear();
+		auto table = A5LookupTable::Get();
+		for (auto cell : current) {
+			neighbours.clear();
+			if (!table || !table->ForEachNeighbour(cell, [&](uint64_t neighbour) { neighbours.push_back(neighbour); })) {
+				ThrowRustError(a5_grid_disk_into(cell, 1, A5VectorSink<uint64_t>, &neighbours), function_name);
+			}
+			for (auto neighbour : neighbours) {
+				if (seen.insert(neighbour).second) {
+					next.push_back(neighbour);
+				}
+			}
+		}
+		std::sort(next.begin(), next.end());
+		// Only rings k and k + 1 can be reached from ring k + 1; forget ring k - 1
+		for (auto cell : previous) {
+			seen.erase(cell);
+		}
+		std::swap(previous, current);
+		std::swap(current, next);
+		k++;
+	}
+
+	// Advances until ring `target_k`
+	void AdvanceTo(int32_t target_k) {
+		while (k < target_k && !current.empty()) {
+			Next();
+		}
+	}
+
+private:
+	const char *function_name;
+	int32_t k;
+	vector<uint64_t> previous;
+	vector<uint64_t> current;
+	vector<uint64_t> next;
+	vector<uint64_t> neighbours;
+	// Cells of rings k - 1 and k, then also of the ring being built
+	unordered_set<uint64_t> seen;
+};
+
+} // namespace duckdb
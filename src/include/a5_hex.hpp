@@ -0,0 +1,107 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/bswap.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+// A5 cells are written as lowercase hexadecimal without leading zeros, matching a5::u64_to_hex.
+// The longest encoding is 16 characters.
+static constexpr idx_t A5_MAX_HEX_LENGTH = 16;
+
+// Value of a hex digit, or -1 if `c` is not one
+inline int32_t A5HexNibble(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	char lower = static_cast<char>(c | 0x20);
+	if (lower >= 'a' && lower <= 'f') {
+		return lower - 'a' + 10;
+	}
+	return -1;
+}
+
+// Per-byte mask of the bytes of `x` that lie in [lo, hi], as their high bit. Every byte of `x` must
+// be below 0x80 so that the additions cannot carry into the next byte.
+static inline uint64_t A5BytesInRange(uint64_t x, uint8_t lo, uint8_t hi) {
+	static constexpr uint64_t ONES = 0x0101010101010101ULL;
+	static constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+	auto at_least_lo = x + ONES * (0x80 - lo);
+	auto above_hi = x + ONES * (0x7F - hi);
+	return at_least_lo & ~above_hi & HIGH_BITS;
+}
+
+// Decodes eight hex digits, first digit in the lowest byte of `x`, into a 32-bit value. Validates and
+// converts all eight bytes at once instead of branching per character.
+static inline bool A5DecodeHex8(uint64_t x, uint64_t &value) {
+	static constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+	if (x & HIGH_BITS) {
+		return false;
+	}
+	auto digits = A5BytesInRange(x, '0', '9');
+	auto letters = A5BytesInRange(x | 0x2020202020202020ULL, 'a', 'f');
+	if ((digits | letters) != HIGH_BITS) {
+		return false;
+	}
+	// '0'-'9' keep their low nibble; letters of either case have bit 6 set and a low nibble of 1-6
+	auto nibbles = (x & 0x0F0F0F0F0F0F0F0FULL) + 9 * ((x >> 6) & 0x0101010101010101ULL);
+	// Merge neighbouring nibbles, then bytes, then 16-bit halves, most significant digit first
+	auto bytes = ((nibbles & 0x000F000F000F000FULL) << 4) | ((nibbles >> 8) & 0x000F000F000F000FULL);
+	auto words = ((bytes & 0x000000FF000000FFULL) << 8) | ((bytes >> 16) & 0x000000FF000000FFULL);
+	value = ((words & 0xFFFFULL) << 16) | (words >> 32);
+	return true;
+}
+
+// Reads eight characters with the first one in the lowest byte
+static inline uint64_t A5LoadHexChars(const char *data) {
+	uint64_t x;
+	memcpy(&x, data, sizeof(x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = BSwap(x);
+#endif
+	return x;
+}
+
+// Decodes 1 to 16 hex digits (either case) into `cell`. Returns false for anything else.
+inline bool A5DecodeHex(const char *data, idx_t length, uint64_t &cell) {
+	if (length == A5_MAX_HEX_LENGTH) {
+		// Cells at resolution 1 and finer almost always use all 16 digits
+		uint64_t high, low;
+		if (!A5DecodeHex8(A5LoadHexChars(data), high) || !A5DecodeHex8(A5LoadHexChars(data + 8), low)) {
+			return false;
+		}
+		cell = (high << 32) | low;
+		return true;
+	}
+	if (length == 0 || length > A5_MAX_HEX_LENGTH) {
+		return false;
+	}
+	uint64_t value = 0;
+	for (idx_t i = 0; i < length; i++) {
+		auto nibble = A5HexNibble(data[i]);
+		if (nibble < 0) {
+			return false;
+		}
+		value = (value << 4) | static_cast<uint64_t>(nibble);
+	}
+	cell = value;
+	return true;
+}
+
+// Encodes `cell` into `buffer` (at least A5_MAX_HEX_LENGTH bytes) and returns the length written
+inline idx_t A5EncodeHex(uint64_t cell, char *buffer) {
+	static constexpr char DIGITS[] = "0123456789abcdef";
+	idx_t length = 1;
+	for (auto rest = cell >> 4; rest != 0; rest >>= 4) {
+		length++;
+	}
+	for (idx_t i = length; i > 0; i--) {
+		buffer[i - 1] = DIGITS[cell & 0xF];
+		cell >>= 4;
+	}
+	return length;
+}
+
+} // namespace duckdb
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/bit_utils.hpp"
+
+namespace duckdb {
+
+// Bit layout of an A5 cell index, mirroring the serialization of the a5 crate:
+//
+//   bits 63..58  origin * 5 + segment, or just the origin at resolution 0
+//   bits 57..    two bits of the Hilbert index per resolution level from resolution 2 onwards
+//   marker       a single set bit directly below the used bits; its position encodes the resolution
+//
+// Resolution 30 cells have no room for a marker bit and, like malformed indices, are left to the
+// Rust implementation. Every helper returns false when it cannot answer inline so callers can fall
+// back to the FFI for the authoritative result or error message.
+namespace a5_index {
+
+static constexpr int32_t HILBERT_START_BIT = 58;
+static constexpr int32_t FIRST_HILBERT_RESOLUTION = 2;
+static constexpr int32_t MAX_INLINE_RESOLUTION = 29;
+static constexpr int32_t MAX_CELL_RESOLUTION = 30;
+static constexpr uint64_t NUM_ORIGINS = 12;
+static constexpr uint64_t SEGMENTS_PER_ORIGIN = 5;
+static constexpr uint64_t ORIGIN_SEGMENT_MASK = uint64_t(0x3F) << HILBERT_START_BIT;
+
+// Position of the resolution marker bit for resolutions 0 to 29
+constexpr int32_t MarkerBit(int32_t resolution) {
+	return resolution < FIRST_HILBERT_RESOLUTION ? HILBERT_START_BIT - 1 - resolution
+	                                             : HILBERT_START_BIT + 1 - 2 * resolution;
+}
+
+// Number of cells at a resolution: the 12 origins, split into 5 segments at resolution 1, then into 4
+// Hilbert children per level
+constexpr uint64_t NumCells(int32_t resolution) {
+	return resolution == 0 ? NUM_ORIGINS : (NUM_ORIGINS * SEGMENTS_PER_ORIGIN) << (2 * (resolution - 1));
+}
+
+// Area of the authalic sphere the a5 crate divides equally among the cells of a resolution
+static constexpr double AUTHALIC_RADIUS = 6371007.2;
+static constexpr double AUTHALIC_AREA = 4 * 3.141592653589793 * AUTHALIC_RADIUS * AUTHALIC_RADIUS;
+
+static constexpr uint64_t NUM_CELLS[] = {
+    NumCells(0),  NumCells(1),  NumCells(2),  NumCells(3),  NumCells(4),  NumCells(5),  NumCells(6),  NumCells(7),
+    NumCells(8),  NumCells(9),  NumCells(10), NumCells(11), NumCells(12), NumCells(13), NumCells(14), NumCells(15),
+    NumCells(16), NumCells(17), NumCells(18), NumCells(19), NumCells(20), NumCells(21), NumCells(22), NumCells(23),
+    NumCells(24), NumCells(25), NumCells(26), NumCells(27), NumCells(28), NumCells(29), NumCells(30)};
+
+#define A5_CELL_AREA(resolution) (AUTHALIC_AREA / static_cast<double>(NumCells(resolution)))
+static constexpr double CELL_AREA[] = {
+    A5_CELL_AREA(0),  A5_CELL_AREA(1),  A5_CELL_AREA(2),  A5_CELL_AREA(3),  A5_CELL_AREA(4),  A5_CELL_AREA(5),
+    A5_CELL_AREA(6),  A5_CELL_AREA(7),  A5_CELL_AREA(8),  A5_CELL_AREA(9),  A5_CELL_AREA(10), A5_CELL_AREA(11),
+    A5_CELL_AREA(12), A5_CELL_AREA(13), A5_CELL_AREA(14), A5_CELL_AREA(15), A5_CELL_AREA(16), A5_CELL_AREA(17),
+    A5_CELL_AREA(18), A5_CELL_AREA(19), A5_CELL_AREA(20), A5_CELL_AREA(21), A5_CELL_AREA(22), A5_CELL_AREA(23),
+    A5_CELL_AREA(24), A5_CELL_AREA(25), A5_CELL_AREA(26), A5_CELL_AREA(27), A5_CELL_AREA(28), A5_CELL_AREA(29),
+    A5_CELL_AREA(30)};
+#undef A5_CELL_AREA
+
+// Descendants of a cell at a finer resolution: every level below resolution 1 multiplies by 4
+constexpr uint64_t NumChildren(int32_t parent_resolution, int32_t child_resolution) {
+	return NumCells(child_resolution) / NumCells(parent_resolution);
+}
+
+// Clears everything below the resolution's marker bit and sets that bit. For valid cells at or below
+// `resolution` this is their ancestor; the mapping is monotonic for any index, so it also maps
+// bounds on a set of cells to bounds on their ancestors.
+constexpr uint64_t TruncateToResolution(uint64_t index, int32_t resolution) {
+	return resolution == 0 ? (((index >> HILBERT_START_BIT) / SEGMENTS_PER_ORIGIN) << HILBERT_START_BIT) |
+	                             (uint64_t(1) << MarkerBit(0))
+	       : resolution == 1 ? (index & ORIGIN_SEGMENT_MASK) | (uint64_t(1) << MarkerBit(1))
+	                         : (index & ~((uint64_t(2) << MarkerBit(resolution)) - 1)) |
+	                               (uint64_t(1) << MarkerBit(resolution));
+}
+
+inline bool GetResolution(uint64_t index, int32_t &resolution) {
+	if (index == 0) {
+		return false;
+	}
+	auto marker = static_cast<int32_t>(CountZeros<uint64_t>::Trailing(index));
+	if (marker == MarkerBit(0)) {
+		resolution = 0;
+		return true;
+	}
+	if (marker == MarkerBit(1)) {
+		resolution = 1;
+		return true;
+	}
+	if (marker % 2 == 1 && marker <= MarkerBit(FIRST_HILBERT_RESOLUTION)) {
+		resolution = (HILBERT_START_BIT + 1 - marker) / 2;
+		return true;
+	}
+	return false;
+}
+
+// Whether the origin/segment prefix is in range for a cell of the given resolution
+inline bool HasValidPrefix(uint64_t index, int32_t resolution) {
+	auto prefix = index >> HILBERT_START_BIT;
+	return resolution == 0 ? prefix < NUM_ORIGINS : prefix < NUM_ORIGINS * SEGMENTS_PER_ORIGIN;
+}
+
+inline bool IsValidCell(uint64_t index, bool &valid) {
+	int32_t resolution;
+	if (!GetResolution(index, resolution)) {
+		return false;
+	}
+	valid = HasValidPrefix(index, resolution);
+	return true;
+}
+
+inline bool CellToParent(uint64_t index, int32_t parent_resolution, uint64_t &parent) {
+	int32_t resolution;
+	if (!GetResolution(index, resolution) || !HasValidPrefix(index, resolution) || parent_resolution < 0 ||
+	    parent_resolution > resolution) {
+		return false;
+	}
+	if (parent_resolution == resolution) {
+		parent = index;
+		return true;
+	}
+	parent = TruncateToResolution(index, parent_resolution);
+	return true;
+}
+
+// Smallest and largest index a descendant of `index` (at any resolution) can have. Descendant
+// ranges of different cells are either nested or disjoint. The range of a resolution 0 cell spans
+// its five segments and does not contain the resolution 0 index itself.
+inline bool CellToRange(uint64_t index, uint64_t &lo, uint64_t &hi) {
+	int32_t resolution;
+	if (!GetResolution(index, resolution) || !HasValidPrefix(index, resolution)) {
+		return false;
+	}
+	if (resolution == 0) {
+		auto first_prefix = (index >> HILBERT_START_BIT) * SEGMENTS_PER_ORIGIN;
+		lo = first_prefix << HILBERT_START_BIT;
+		hi = ((first_prefix + SEGMENTS_PER_ORIGIN) << HILBERT_START_BIT) - 1;
+		return true;
+	}
+	auto free_bits = resolution == 1 ? ~ORIGIN_SEGMENT_MASK : (uint64_t(2) << MarkerBit(resolution)) - 1;
+	lo = index & ~free_bits;
+	hi = index | free_bits;
+	return true;
+}
+
+// Dense position of a cell among the cells of its resolution: the origin at resolution 0, otherwise the
+// origin/segment prefix followed by the Hilbert digits. Inverse of OffsetToCell.
+inline bool CellToOffset(uint64_t index, int32_t &resolution, uint64_t &offset) {
+	if (!GetResolution(index, resolution) || !HasValidPrefix(index, resolution)) {
+		return false;
+	}
+	auto prefix = index >> HILBERT_START_BIT;
+	if (resolution < FIRST_HILBERT_RESOLUTION) {
+		offset = prefix;
+	} else {
+		auto hilbert = (index & ((uint64_t(1) << HILBERT_START_BIT) - 1)) >> (MarkerBit(resolution) + 1);
+		offset = (prefix << (2 * (resolution - 1))) | hilbert;
+	}
+	return true;
+}
+
+// The cell at a dense position of a resolution up to 29; `offset` must be below NumCells(resolution)
+inline uint64_t OffsetToCell(uint64_t offset, int32_t resolution) {
+	auto marker = uint64_t(1) << MarkerBit(resolution);
+	if (resolution < FIRST_HILBERT_RESOLUTION) {
+		return (offset << HILBERT_START_BIT) | marker;
+	}
+	auto hilbert_bits = 2 * (resolution - 1);
+	auto prefix = offset >> hilbert_bits;
+	auto hilbert = offset & ((uint64_t(1) << hilbert_bits) - 1);
+	return (prefix << HILBERT_START_BIT) | (hilbert << (MarkerBit(resolution) + 1)) | marker;
+}
+
+// Smallest and largest index among the descendants of `index` at `target_resolution`. Unlike
+// CellToRange this also handles resolution 30 targets, whose indices carry no marker bit.
+inline bool CellToDescendantRange(uint64_t index, int32_t target_resolution, uint64_t &lo, uint64_t &hi) {
+	int32_t resolution;
+	if (!GetResolution(index, resolution) || !HasValidPrefix(index, resolution) || target_resolution < resolution ||
+	    target_resolution > MAX_CELL_RESOLUTION) {
+		return false;
+	}
+	if (target_resolution == resolution) {
+		lo = hi = index;
+		return true;
+	}
+	auto target_marker =
+	    target_resolution > MAX_INLINE_RESOLUTION ? uint64_t(0) : uint64_t(1) << MarkerBit(target_resolution);
+	// Hilbert bits of the levels between the two resolutions, all set
+	uint64_t target_bits = 0;
+	if (target_resolution >= FIRST_HILBERT_RESOLUTION) {
+		auto below_target = target_marker == 0 ? uint64_t(0) : (target_marker << 1) - 1;
+		target_bits = ((uint64_t(1) << HILBERT_START_BIT) - 1) & ~below_target;
+	}
+	if (resolution == 0) {
+		auto first_prefix = (index >> HILBERT_START_BIT) * SEGMENTS_PER_ORIGIN;
+		lo = (first_prefix << HILBERT_START_BIT) | target_marker;
+		hi = ((first_prefix + SEGMENTS_PER_ORIGIN - 1) << HILBERT_START_BIT) | target_bits | target_marker;
+		return true;
+	}
+	auto free_bits = resolution == 1 ? ~ORIGIN_SEGMENT_MASK : (uint64_t(2) << MarkerBit(resolution)) - 1;
+	lo = (index & ~free_bits) | target_marker;
+	hi = (index & ~free_bits) | (target_bits & free_bits) | target_marker;
+	return true;
+}
+
+} // namespace a5_index
+} // namespace duckdb
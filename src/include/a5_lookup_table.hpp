@@ -0,0 +1,206 @@
+#pragma once
+
+#include "a5_common.hpp"
+
+namespace duckdb {
+
+// Finest resolution a lookup table may cover. Resolution 8 has under a million cells, so every offset
+// into the table fits in 32 bits.
+static constexpr int32_t A5_MAX_LOOKUP_RESOLUTION = 8;
+
+class A5MappedFile;
+
+// Precomputed centroids, boundaries and neighbours of every cell up to a coarse resolution, read from a
+// file written by a5_write_lookup_table and memory-mapped in place. The mapping shares the file's pages,
+// so the file must not be modified or truncated while a database has it loaded; a5_write_lookup_table
+// replaces an existing file by renaming a new one over it, which leaves loaded tables intact. Cells of a covered resolution are
+// found by their dense offset (a5_index::CellToOffset), so serving them is a memory load. The values
+// are the exact output of the Rust functions, stored as:
+//
+//   header    "A5LOOKUP", version, byte order mark, finest resolution, then one section per resolution
+//   section   cell count and the file offsets of the arrays below
+//   arrays    centroids (lon/lat per cell); boundary offsets (count + 1) and points of the closed
+//             default boundaries; neighbour offsets (count + 1) and the dense offsets of the cells of
+//             a5_grid_disk(cell, 1)
+class A5LookupTable {
+public:
+	~A5LookupTable();
+
+	// The table of the database the calling thread is working for, or nullptr. It is set by
+	// A5LookupTableScope: around every chunk of the a5 scalar functions, and by the table functions and
+	// optimizer rules that read cell geometry.
+	static const A5LookupTable *Get() {
+		return thread_table;
+	}
+
+	// Maps and validates the file
+	static unique_ptr<A5LookupTable> Load(const string &path);
+
+	int32_t MaxResolution() const {
+		return static_cast<int32_t>(sections.size()) - 1;
+	}
+
+	bool Centroid(uint64_t cell, LonLatDegrees &centroid) const {
+		const Section *section;
+		uint64_t offset;
+		if (!Locate(cell, section, offset)) {
+			return false;
+		}
+		centroid = section->centroids[offset];
+		return true;
+	}
+
+	// The closed boundary of a5_cell_to_boundary with the default segments
+	bool Boundary(uint64_t cell, const LonLatDegrees *&points, idx_t &count) const {
+		const Section *section;
+		uint64_t offset;
+		if (!Locate(cell, section, offset)) {
+			return false;
+		}
+		points = section->boundary_points + section->boundary_offsets[offset];
+		count = section->boundary_offsets[offset + 1] - section->boundary_offsets[offset];
+		return true;
+	}
+
+	// The cells of a5_grid_disk(cell, 1), in the order the Rust implementation returns them
+	template <class FUNC>
+	bool ForEachNeighbour(uint64_t cell, FUNC &&func) const {
+		const Section *section;
+		uint64_t offset;
+		if (!Locate(cell, section, offset)) {
+			return false;
+		}
+		for (auto i = section->neighbour_offsets[offset]; i < section->neighbour_offsets[offset + 1]; i++) {
+			func(a5_index::OffsetToCell(section->neighbours[i], section->resolution));
+		}
+		return true;
+	}
+
+	idx_t NeighbourCount(uint64_t cell) const {
+		const Section *section;
+		uint64_t offset;
+		if (!Locate(cell, section, offset)) {
+			return 0;
+		}
+		return section->neighbour_offsets[offset + 1] - section->neighbour_offsets[offset];
+	}
+
+private:
+	struct Section {
+		int32_t resolution;
+		uint64_t cell_count;
+		const LonLatDegrees *centroids;
+		const uint32_t *boundary_offsets;
+		const LonLatDegrees *boundary_points;
+		const uint32_t *neighbour_offsets;
+		const uint32_t *neighbours;
+	};
+
+	A5LookupTable() = default;
+
+	bool Locate(uint64_t cell, const Section *&section, uint64_t &offset) const {
+		int32_t resolution;
+		if (!a5_index::CellToOffset(cell, resolution, offset) || resolution >= static_cast<int32_t>(sections.size())) {
+			return false;
+		}
+		// Indices with stray bits below the marker map onto a valid offset; only canonical cells are served
+		if (a5_index::OffsetToCell(offset, resolution) != cell) {
+			return false;
+		}
+		section = &sections[resolution];
+		return true;
+	}
+
+	friend class A5LookupTableScope;
+	static thread_local const A5LookupTable *thread_table;
+
+	unique_ptr<A5MappedFile> file;
+	vector<Section> sections;
+};
+
+// Makes a table the one A5LookupTable::Get() returns on the calling thread until destroyed
+class A5LookupTableScope {
+public:
+	explicit A5LookupTableScope(const A5LookupTable *table) : previous(A5LookupTable::thread_table) {
+		A5LookupTable::thread_table = table;
+	}
+
+	~A5LookupTableScope() {
+		A5LookupTable::thread_table = previous;
+	}
+
+private:
+	const A5LookupTable *previous;
+};
+
+// The table loaded in the database by the a5_lookup_table setting or the A5_LOOKUP_TABLE environment
+// variable, or nullptr. Replaced tables stay mapped until the database is closed, so a running query
+// never loses one.
+const A5LookupTable *A5GetLookupTable(ClientContext &context);
+
+// Drop-in replacements for the Rust entry points that answer from the lookup table when it covers the
+// cell and the options (boundaries only with the default segments), and call Rust otherwise
+
+inline int32_t A5CellToBoundaryInto(uint64_t cell, CellBoundaryOptions options, LonLatSink sink, void *ctx) {
+	auto table = A5LookupTable::Get();
+	const LonLatDegrees *points;
+	idx_t count;
+	if (table && options.segments < 0 && table->Boundary(cell, points, count)) {
+		// The open ring is the closed one without the repeated first point
+		count -= options.closed_ring || count == 0 ? 0 : 1;
+		auto out = sink(ctx, count);
+		if (!out) {
+			return A5_ERROR_ALLOCATION;
+		}
+		memcpy(out, points, count * sizeof(LonLatDegrees));
+		return A5_OK;
+	}
+	return a5_cell_to_boundary_into(cell, options, sink, ctx);
+}
+
+// Same contract as a5_cell_to_lon_lat_batch
+inline uintptr_t A5CellToLonLatBatch(const uint64_t *cells, double *out, uint64_t *validity, uintptr_t len) {
+	auto table = A5LookupTable::Get();
+	if (!table) {
+		return a5_cell_to_lon_lat_batch(cells, out, validity, len);
+	}
+	// Rows answered by the table are hidden from Rust, which writes zeros for them, and their validity
+	// and centroids are restored afterwards
+	uint64_t served[(STANDARD_VECTOR_SIZE + 63) / 64];
+	auto words = (len + 63) / 64;
+	bool all_served = true;
+	for (idx_t w = 0; w < words; w++) {
+		served[w] = 0;
+		for (auto bits = validity[w]; bits; bits &= bits - 1) {
+			auto row = w * 64 + CountZeros<uint64_t>::Trailing(bits);
+			LonLatDegrees centroid;
+			if (table->Centroid(cells[row], centroid)) {
+				out[row * 2] = centroid.lon;
+				out[row * 2 + 1] = centroid.lat;
+				served[w] |= uint64_t(1) << (row % 64);
+			}
+		}
+		validity[w] &= ~served[w];
+		all_served = all_served && validity[w] == 0;
+	}
+	uintptr_t failed = all_served ? 0 : a5_cell_to_lon_lat_batch(cells, out, validity, len);
+	for (idx_t w = 0; w < words; w++) {
+		if (!all_served) {
+			for (auto bits = served[w]; bits; bits &= bits - 1) {
+				auto row = w * 64 + CountZeros<uint64_t>::Trailing(bits);
+				LonLatDegrees centroid;
+				table->Centroid(cells[row], centroid);
+				out[row * 2] = centroid.lon;
+				out[row * 2 + 1] = centroid.lat;
+			}
+		}
+		validity[w] |= served[w];
+	}
+	return failed;
+}
+
+// Same contract as a5_grid_disk_into, and the same order: only disks of k = 1, whose cells the table
+// stores in the order of the Rust implementation, are served from it
+int32_t A5GridDiskInto(uint64_t cell, uintptr_t k, CellSink sink, void *ctx);
+
+} // namespace duckdb
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "a5_common.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/execution/expression_executor_state.hpp"
+
+#include <list>
+
+namespace duckdb {
+
+// Functions whose results are memoized by A5NeighborhoodCache
+enum class A5NeighborhoodFunction : uint8_t { SPHERICAL_CAP = 0, GRID_DISK = 1, GRID_DISK_VERTEX = 2, GRID_RING = 3 };
+
+static constexpr idx_t A5_NEIGHBORHOOD_FUNCTION_COUNT = 4;
+
+// Adds a chunk's hits and misses to the process-wide counters reported by a5_neighborhood_cache_stats
+void A5RecordNeighborhoodCacheStats(A5NeighborhoodFunction function, idx_t hits, idx_t misses);
+
+// Results with more cells than this are returned but not cached: one of them would take the memory of
+// hundreds of typical entries, and large neighborhoods are rarely requested twice in a row
+static constexpr idx_t A5_MAX_CACHED_NEIGHBORHOOD_CELLS = 1024;
+
+// Cells a cache keeps per entry of its capacity. Past capacity times this, least recently used entries
+// are evicted even when fewer than capacity are cached.
+static constexpr idx_t A5_NEIGHBORHOOD_CACHE_CELLS_PER_ENTRY = 64;
+
+// Bounded LRU of neighborhood results keyed on (cell, k) or (cell, radius). Many input points fall in
+// the same cell, so the same neighborhood is requested over and over within one thread. Both the number
+// of entries and the total cells they hold are bounded.
+class A5NeighborhoodCache {
+public:
+	explicit A5NeighborhoodCache(idx_t capacity)
+	    : capacity(capacity),
+	      max_cells(capacity > NumericLimits<idx_t>::Maximum() / A5_NEIGHBORHOOD_CACHE_CELLS_PER_ENTRY
+	                    ? NumericLimits<idx_t>::Maximum()
+	                    : capacity * A5_NEIGHBORHOOD_CACHE_CELLS_PER_ENTRY),
+	      cached_cells(0) {
+	}
+
+	bool Enabled() const {
+		return capacity > 0;
+	}
+
+	// Returns the cached cells, marking the entry as most recently used, or nullptr on a miss
+	const vector<uint64_t> *Find(uint64_t cell, uint64_t param) {
+		auto entry = index.find(Key {cell, param});
+		if (entry == index.end()) {
+			return nullptr;
+		}
+		entries.splice(entries.begin(), entries, entry->second);
+		return &entry->second->cells;
+	}
+
+	// Keeps a copy of `count` cells, unless they are too many to be worth caching
+	void Insert(uint64_t cell, uint64_t param, const uint64_t *cells, idx_t count) {
+		if (count > A5_MAX_CACHED_NEIGHBORHOOD_CELLS) {
+			return;
+		}
+		while (!entries.empty() && (entries.size() >= capacity || cached_cells + count > max_cells)) {
+			cached_cells -= entries.back().cells.size();
+			index.erase(entries.back().key);
+			entries.pop_back();
+		}
+		entries.push_front(Entry {Key {cell, param}, vector<uint64_t>(cells, cells + count)});
+		index[entries.front().key] = entries.begin();
+		cached_cells += count;
+	}
+
+private:
+	struct Key {
+		uint64_t cell;
+		uint64_t param;
+
+		bool operator==(const Key &other) const {
+			return cell == other.cell && param == other.param;
+		}
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key &key) const {
+			return CombineHash(Hash(key.cell), Hash(key.param));
+		}
+	};
+
+	struct Entry {
+		Key key;
+		vector<uint64_t> cells;
+	};
+
+	idx_t capacity;
+	idx_t max_cells;
+	// Cells held by all entries
+	idx_t cached_cells;
+	// Most recently used first
+	std::list<Entry> entries;
+	unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+};
+
+struct A5NeighborhoodLocalState : public FunctionLocalState {
+	explicit A5NeighborhoodLocalState(idx_t capacity) : cache(capacity) {
+	}
+
+	A5NeighborhoodCache cache;
+};
+
+// init_local_state for the neighborhood functions; sized by the a5_neighborhood_cache_size setting
+unique_ptr<FunctionLocalState> A5NeighborhoodInitLocalState(ExpressionState &state, const BoundFunctionExpression &expr,
+                                                            FunctionData *bind_data);
+
+} // namespace duckdb
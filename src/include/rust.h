@@ -8,15 +8,36 @@
 #include <ostream>
 #include <new>
 
+/// Status codes returned by every fallible entry point. Failing calls only record their message
+/// for the calling thread; it is formatted for the caller on demand by `a5_last_error_message`,
+/// so rows that fail inside a TRY_ function never cross the FFI boundary as heap strings.
+constexpr static const int32_t A5_OK = 0;
+
+/// The a5 crate rejected the input; the message is available from `a5_last_error_message`
+constexpr static const int32_t A5_ERROR = 1;
+
+/// The caller's sink could not provide an output buffer
+constexpr static const int32_t A5_ERROR_ALLOCATION = 2;
+
+/// Allocation callbacks of the caller, typically its memory-tracked allocator. `allocate` returns
+/// null when it cannot serve the request (for example past a memory limit), in which case the
+/// allocation falls back to the system allocator and is counted for `a5_take_allocator_fallbacks`.
+/// `free` receives the size passed to `allocate`.
+struct A5Allocator {
+  void *(*allocate)(void *ctx, uintptr_t size);
+  void (*free)(void *ctx, void *ptr, uintptr_t size);
+  void *ctx;
+};
+
 struct ResultU64 {
   uint64_t value;
-  char *error;
+  int32_t error_code;
 };
 
 struct ResultLonLat {
   double longitude;
   double latitude;
-  char *error;
+  int32_t error_code;
 };
 
 struct LonLatDegrees {
@@ -24,18 +45,21 @@ struct LonLatDegrees {
   double lat;
 };
 
-struct LonLatDegreesArray {
-  LonLatDegrees *data;
-  uintptr_t len;
-  char *error;
-};
-
 struct CellArray {
   uint64_t *data;
   uintptr_t len;
-  char *error;
+  int32_t error_code;
 };
 
+/// Callback through which the caller provides the output buffer for a variable-length cell
+/// result. It is called at most once per call with the number of cells produced and must return
+/// a buffer with room for at least `len` cells, or null if the buffer could not be allocated.
+using CellSink = uint64_t*(*)(void *ctx, uintptr_t len);
+
+/// Callback through which the caller provides the output buffer for a variable-length list of
+/// points. Same contract as `CellSink`, with room for `len` lon/lat pairs.
+using LonLatSink = LonLatDegrees*(*)(void *ctx, uintptr_t len);
+
 struct CellBoundaryOptions {
   bool closed_ring;
   /// Number of segments to use for each edge. Pass None to use the resolution of the cell (default: None)
@@ -45,51 +69,100 @@ struct CellBoundaryOptions {
 struct ResultSpherical {
   double theta;
   double phi;
-  char *error;
+  int32_t error_code;
 };
 
 extern "C" {
 
+/// Returns the message of the last `A5_ERROR` on the calling thread as UTF-8 bytes that are not
+/// NUL-terminated, with their length in `len`. The bytes stay valid until the next failing call on
+/// the same thread.
+const char *a5_last_error_message(uintptr_t *len);
+
+/// Turns allocation routing on or off for the whole process. Threads only route while they also
+/// have an allocator set with `a5_set_thread_allocator`.
+void a5_set_allocator_routing(bool enabled);
+
+/// Routes the allocations the calling thread makes in subsequent calls through `allocator`, or
+/// back to the system allocator when it is null, and returns the previous allocator of the thread
+/// so the caller can restore it. The callbacks must stay callable for as long as any block they
+/// handed out may be freed: blocks remember the allocator that served them, so switching
+/// allocators never frees a block through the wrong one.
+const A5Allocator *a5_set_thread_allocator(const A5Allocator *allocator);
+
+/// Returns the number of allocations the calling thread made while it had an allocator set that
+/// were served by the system allocator instead, because the allocator returned null or the block
+/// could not be registered, and resets the count
+uint64_t a5_take_allocator_fallbacks();
+
 ResultU64 a5_lon_lat_to_cell(double longitude, double latitude, int32_t resolution);
 
+/// Converts `len` longitude/latitude pairs to cells in a single call, writing into the
+/// caller-owned `out` buffer. `validity` is a bitmap of `(len + 63) / 64` words with one bit
+/// per row: rows whose bit is clear on entry are skipped, and rows that fail to convert have
+/// their bit cleared on return. When `constant_resolution` is true only `resolutions[0]` is read.
+/// Each point is first tested against the cell of the previous row, so spatially ordered input
+/// skips most full lookups. Returns the number of rows that failed to convert; a row on which the
+/// a5 crate panics counts as failed.
+uintptr_t a5_lon_lat_to_cell_batch(const double *longitudes,
+                                   const double *latitudes,
+                                   const int32_t *resolutions,
+                                   bool constant_resolution,
+                                   uint64_t *out,
+                                   uint64_t *validity,
+                                   uintptr_t len);
+
 ResultU64 a5_cell_to_parent(uint64_t index, int32_t parent_resolution);
 
 double a5_cell_area(int32_t resolution);
 
 ResultLonLat a5_cell_to_lon_lat(uint64_t cell);
 
+/// Writes the [longitude, latitude] center of `len` cells into `out`, which has room for
+/// `2 * len` interleaved doubles, in a single call. `validity` follows the contract of
+/// `a5_lon_lat_to_cell_batch`. Consecutive repeated cells are converted once. Returns the number
+/// of cells that failed to convert.
+uintptr_t a5_cell_to_lon_lat_batch(const uint64_t *cells, double *out, uint64_t *validity, uintptr_t len);
+
+/// Like `a5_cell_to_lon_lat_batch`, writing [theta, phi] in radians.
+uintptr_t a5_cell_to_spherical_batch(const uint64_t *cells, double *out, uint64_t *validity, uintptr_t len);
+
 uint64_t a5_get_num_cells(int32_t resolution);
 
 int32_t a5_get_resolution(uint64_t index);
 
-void a5_free_lonlatdegrees_array(LonLatDegreesArray arr);
-
 void a5_free_cell_array(CellArray arr);
 
-LonLatDegreesArray a5_cell_to_boundary(uint64_t cell_id, CellBoundaryOptions options);
+int32_t a5_cell_to_boundary_into(uint64_t cell_id,
+                                 CellBoundaryOptions options,
+                                 LonLatSink sink,
+                                 void *ctx);
 
-CellArray a5_cell_to_children(uint64_t index, int32_t child_resolution);
+int32_t a5_cell_to_children_into(uint64_t index, int32_t child_resolution, CellSink sink, void *ctx);
 
 CellArray a5_get_res0_cells();
 
-CellArray a5_compact(const uint64_t *cells, uintptr_t len);
-
-CellArray a5_uncompact(const uint64_t *cells, uintptr_t len, int32_t target_resolution);
-
-void a5_free_string(char *ptr);
+int32_t a5_compact_into(const uint64_t *cells, uintptr_t len, CellSink sink, void *ctx);
 
-ResultU64 a5_hex_to_u64(const char *hex);
+int32_t a5_uncompact_into(const uint64_t *cells,
+                          uintptr_t len,
+                          int32_t target_resolution,
+                          CellSink sink,
+                          void *ctx);
 
-char *a5_u64_to_hex(uint64_t value);
+/// Parses the `len` bytes at `hex`, which need not be NUL-terminated. The extension decodes
+/// well-formed cell strings itself and only calls this for the rest, so errors are reported with
+/// the crate's message.
+ResultU64 a5_hex_to_u64(const char *hex, uintptr_t len);
 
 uintptr_t a5_get_num_children(int32_t parent_res, int32_t child_res);
 
 ResultSpherical a5_cell_to_spherical(uint64_t cell);
 
-CellArray a5_spherical_cap(uint64_t cell_id, double radius);
+int32_t a5_spherical_cap_into(uint64_t cell_id, double radius, CellSink sink, void *ctx);
 
-CellArray a5_grid_disk(uint64_t cell_id, uintptr_t k);
+int32_t a5_grid_disk_into(uint64_t cell_id, uintptr_t k, CellSink sink, void *ctx);
 
-CellArray a5_grid_disk_vertex(uint64_t cell_id, uintptr_t k);
+int32_t a5_grid_disk_vertex_into(uint64_t cell_id, uintptr_t k, CellSink sink, void *ctx);
 
 }  // extern "C"
@@ -1,12 +1,12 @@
 #include "query_farm_telemetry.hpp"
 #include <thread>
 #include "duckdb.hpp"
+#include "duckdb/common/file_system.hpp"
 #include "duckdb/common/http_util.hpp"
 #include "yyjson.hpp"
 #include "duckdb/main/extension_helper.hpp"
 #include "duckdb/main/config.hpp"
 #include <cstdlib>
-#include <future>
 using namespace duckdb_yyjson; // NOLINT
 
 namespace duckdb
@@ -15,30 +15,123 @@ namespace duckdb
 	namespace
 	{
 
-		// Function to send the actual HTTP request
-		void sendHTTPRequest(shared_ptr<DatabaseInstance> db, char *json_body, size_t json_body_size)
+		// Setting that disables telemetry when false. It can also be passed in the database configuration
+		// before the extension is loaded.
+		const char *TELEMETRY_SETTING = "query_farm_telemetry";
+
+		// Upper bound on the time the background request may take, in seconds
+		const uint64_t TELEMETRY_TIMEOUT_SECONDS = 3;
+
+		bool telemetryEnabled(DatabaseInstance &db)
 		{
-			const string TARGET_URL("https://duckdb-in.query-farm.services/");
+			if (std::getenv("QUERY_FARM_TELEMETRY_OPT_OUT") != nullptr)
+			{
+				return false;
+			}
+			Value enabled;
+			if (db.TryGetCurrentSetting(TELEMETRY_SETTING, enabled) && !enabled.IsNull())
+			{
+				return BooleanValue::Get(enabled);
+			}
+			return true;
+		}
+
+		// Serializes the telemetry payload; the returned buffer must be released with free()
+		char *buildTelemetryBody(const string &extension_name, const string &extension_version, size_t &len)
+		{
+			auto doc = yyjson_mut_doc_new(nullptr);
+
+			auto result_obj = yyjson_mut_obj(doc);
+			yyjson_mut_doc_set_root(doc, result_obj);
+
+			auto platform = DuckDB::Platform();
 
+			yyjson_mut_obj_add_str(doc, result_obj, "extension_name", extension_name.c_str());
+			yyjson_mut_obj_add_str(doc, result_obj, "extension_version", extension_version.c_str());
+			yyjson_mut_obj_add_str(doc, result_obj, "user_agent", "query-farm/20260201");
+			yyjson_mut_obj_add_str(doc, result_obj, "duckdb_platform", platform.c_str());
+			yyjson_mut_obj_add_str(doc, result_obj, "duckdb_library_version", DuckDB::LibraryVersion());
+			yyjson_mut_obj_add_str(doc, result_obj, "duckdb_release_codename", DuckDB::ReleaseCodename());
+			yyjson_mut_obj_add_str(doc, result_obj, "duckdb_source_id", DuckDB::SourceID());
+
+			auto telemetry_data =
+					yyjson_mut_val_write_opts(result_obj, YYJSON_WRITE_ALLOW_INF_AND_NAN, NULL, &len, nullptr);
+
+			yyjson_mut_doc_free(doc);
+			return telemetry_data;
+		}
+
+		const char *TELEMETRY_URL = "https://duckdb-in.query-farm.services/";
+
+		// Sends the request. Only the HTTP utility and its parameters are used, never the database, so the
+		// database may be closed while the request is in flight.
+		void sendHTTPRequest(HTTPUtil &http_util, HTTPParams &params, char *json_body, size_t json_body_size)
+		{
 			HTTPHeaders headers;
 			headers.Insert("Content-Type", "application/json");
 
-			auto &http_util = HTTPUtil::Get(*db);
-			unique_ptr<HTTPParams> params = http_util.InitializeParameters(*db, TARGET_URL);
-
-			PostRequestInfo post_request(TARGET_URL, headers, *params, reinterpret_cast<const_data_ptr_t>(json_body),
-																	 json_body_size);
 			try
 			{
+				PostRequestInfo post_request(TELEMETRY_URL, headers, params, reinterpret_cast<const_data_ptr_t>(json_body),
+																		 json_body_size);
 				auto response = http_util.Request(post_request);
 			}
-			catch (const std::exception &e)
+			catch (...)
 			{
 				// ignore all errors.
 			}
+		}
 
-			free(json_body);
-			return;
+		// Runs the whole telemetry path, including loading httpfs, off the thread that loads the extension.
+		// httpfs is only loaded when it is already installed, never downloaded, so the database is held
+		// only for local work: loading it and reading the request parameters. It is released before the
+		// request, the only network I/O, which TELEMETRY_TIMEOUT_SECONDS bounds; closing the database
+		// mid-request destroys it on the closing thread and frees its file lock at once.
+		void sendTelemetry(weak_ptr<DatabaseInstance> weak_db, string extension_name, string extension_version)
+		{
+			shared_ptr<HTTPUtil> http_util;
+			unique_ptr<HTTPParams> params;
+			{
+				auto db = weak_db.lock();
+				if (!db || !telemetryEnabled(*db))
+				{
+					return;
+				}
+
+				try
+				{
+					if (!db->ExtensionIsLoaded("httpfs"))
+					{
+						// Loads from the local extension directory only; a missing httpfs is not installed
+						ExtensionHelper::LoadExternalExtension(*db, FileSystem::GetFileSystem(*db), "httpfs");
+					}
+					if (!db->ExtensionIsLoaded("httpfs"))
+					{
+						return;
+					}
+					http_util = DBConfig::GetConfig(*db).http_util;
+					if (!http_util)
+					{
+						return;
+					}
+					params = http_util->InitializeParameters(*db, TELEMETRY_URL);
+				}
+				catch (...)
+				{
+					return;
+				}
+				params->timeout = TELEMETRY_TIMEOUT_SECONDS;
+				params->retries = 0;
+			}
+
+			size_t telemetry_len;
+			auto telemetry_data = buildTelemetryBody(extension_name, extension_version, telemetry_len);
+			if (telemetry_data == nullptr)
+			{
+				return;
+			}
+			sendHTTPRequest(*http_util, *params, telemetry_data, telemetry_len);
+			free(telemetry_data);
 		}
 
 	} // namespace
@@ -46,61 +139,33 @@ namespace duckdb
 	INTERNAL_FUNC void QueryFarmSendTelemetry(ExtensionLoader &loader, const string &extension_name,
 																						const string &extension_version)
 	{
-		const char *opt_out = std::getenv("QUERY_FARM_TELEMETRY_OPT_OUT");
-		if (opt_out != nullptr)
+		auto &db = loader.GetDatabaseInstance();
+		auto &config = DBConfig::GetConfig(db);
+		config.AddExtensionOption(TELEMETRY_SETTING,
+															"Send anonymous Query.Farm extension usage telemetry when an extension is loaded",
+															LogicalType::BOOLEAN, Value::BOOLEAN(true));
+
+		// Checked before starting anything, so an opted out load does no work at all
+		if (!telemetryEnabled(db))
 		{
 			return;
 		}
 
+#ifndef __EMSCRIPTEN__
+		// Detached: a std::async future would block in its destructor until the request completed
 		try
 		{
-			ExtensionHelper::TryAutoLoadExtension(loader.GetDatabaseInstance(), "httpfs");
+			std::thread(sendTelemetry, weak_ptr<DatabaseInstance>(db.shared_from_this()), extension_name,
+									extension_version)
+					.detach();
 		}
 		catch (...)
 		{
-			return;
+			// no threads available; skip telemetry rather than delay loading
 		}
-
-		if (!loader.GetDatabaseInstance().ExtensionIsLoaded("httpfs"))
-		{
-			return;
-		}
-
-		// Initialize the telemetry sender
-		auto doc = yyjson_mut_doc_new(nullptr);
-
-		auto result_obj = yyjson_mut_obj(doc);
-		yyjson_mut_doc_set_root(doc, result_obj);
-
-		auto platform = DuckDB::Platform();
-
-		yyjson_mut_obj_add_str(doc, result_obj, "extension_name", extension_name.c_str());
-		yyjson_mut_obj_add_str(doc, result_obj, "extension_version", extension_version.c_str());
-		yyjson_mut_obj_add_str(doc, result_obj, "user_agent", "query-farm/20260201");
-		yyjson_mut_obj_add_str(doc, result_obj, "duckdb_platform", platform.c_str());
-		yyjson_mut_obj_add_str(doc, result_obj, "duckdb_library_version", DuckDB::LibraryVersion());
-		yyjson_mut_obj_add_str(doc, result_obj, "duckdb_release_codename", DuckDB::ReleaseCodename());
-		yyjson_mut_obj_add_str(doc, result_obj, "duckdb_source_id", DuckDB::SourceID());
-
-		size_t telemetry_len;
-		auto telemetry_data =
-				yyjson_mut_val_write_opts(result_obj, YYJSON_WRITE_ALLOW_INF_AND_NAN, NULL, &telemetry_len, nullptr);
-
-		if (telemetry_data == nullptr)
-		{
-			throw SerializationException("Failed to serialize telemetry data.");
-		}
-
-		yyjson_mut_doc_free(doc);
-
-#ifndef __EMSCRIPTEN__
-		[[maybe_unused]] auto _ = std::async(
-				std::launch::async, [db_ptr = loader.GetDatabaseInstance().shared_from_this(), json = telemetry_data,
-														 len = telemetry_len]() mutable
-				{ sendHTTPRequest(std::move(db_ptr), json, len); });
 #else
-		sendHTTPRequest(loader.GetDatabaseInstance().shared_from_this(), telemetry_data, telemetry_len);
+		sendTelemetry(db.shared_from_this(), extension_name, extension_version);
 #endif
 	}
 
-} // namespace duckdb
\ No newline at end of file
+} // namespace duckdb